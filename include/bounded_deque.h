@@ -0,0 +1,331 @@
+//
+// Created by anton on 17.10.26.
+//
+
+#ifndef DEQUE_BOUNDED_DEQUE_H
+#define DEQUE_BOUNDED_DEQUE_H
+
+#include <stdexcept>
+#include <string>
+#include <algorithm>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "deque_iterator.h"
+#include "deque_segment.h"
+
+// Ring of at most capacity() elements that never reallocates, e.g. for "the last N samples".
+//
+// push_back into a full ring evicts the front element, push_front evicts the back one; both
+// return false in that case. When the capacity is a power of two the evicted slot is exactly
+// where the new element goes, so the overwrite is one assignment and one step of _head.
+// Otherwise the ring lives in the next power of two and the evicted element is destroyed.
+template <class T>
+class BoundedDeque {
+
+private:
+
+    T* _buffer = nullptr;
+
+    size_t _head = 0;
+    size_t _size = 0;
+    size_t _capacity = 0;
+    // Size of _buffer, the smallest power of two not less than _capacity
+    size_t _ring_capacity = 0;
+
+    static T* allocate(size_t capacity) {
+        return static_cast<T*>(::operator new(capacity * sizeof(T)));
+    }
+
+    static void deallocate(T* buffer) {
+        ::operator delete(buffer);
+    }
+
+    template <class... Args>
+    static void construct(T* place, Args&&... args) {
+        ::new (static_cast<void*>(place)) T(std::forward<Args>(args)...);
+    }
+
+    inline size_t wrap(size_t pos) const {
+        return pos & (_ring_capacity - 1);
+    }
+
+    inline void init(size_t capacity) {
+        _capacity = capacity;
+        _ring_capacity = 1;
+        while (_ring_capacity < capacity)
+            _ring_capacity <<= 1;
+        _buffer = allocate(_ring_capacity);
+    }
+
+    // The new element is built before the eviction, since the arguments may refer to the evicted one
+    template <class... Args>
+    inline void overwrite_back(Args&&... args) {
+        // A moved-from ring has no capacity and drops every element
+        if (_capacity == 0)
+            return;
+        T elem(std::forward<Args>(args)...);
+        if (_ring_capacity == _capacity) {
+            _buffer[_head] = std::move(elem);
+            _head = wrap(_head + 1);
+            return;
+        }
+        pop_front();
+        construct(_buffer + wrap(_head + _size), std::move(elem));
+        ++_size;
+    }
+
+    template <class... Args>
+    inline void overwrite_front(Args&&... args) {
+        // A moved-from ring has no capacity and drops every element
+        if (_capacity == 0)
+            return;
+        T elem(std::forward<Args>(args)...);
+        if (_ring_capacity == _capacity) {
+            _head = wrap(_head - 1);
+            _buffer[_head] = std::move(elem);
+            return;
+        }
+        pop_back();
+        size_t new_head = wrap(_head - 1);
+        construct(_buffer + new_head, std::move(elem));
+        _head = new_head;
+        ++_size;
+    }
+
+public:
+
+    // Typedef iterators
+
+    typedef DequeIterator<BoundedDeque, T> iterator;
+    typedef DequeIterator<const BoundedDeque, const T> const_iterator;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    // Constructors & destructors
+
+    explicit BoundedDeque(size_t capacity) {
+        if (capacity == 0)
+            throw std::invalid_argument("BoundedDeque::capacity must be positive");
+        init(capacity);
+    }
+
+    BoundedDeque(const BoundedDeque& other) {
+        init(other._capacity);
+        try {
+            for (; _size < other.size(); ++_size)
+                construct(_buffer + _size, other[_size]);
+        } catch (...) {
+            clear();
+            deallocate(_buffer);
+            throw;
+        }
+    }
+
+    // other is left empty, without a buffer, until it is assigned to; pushes to it drop the element
+    BoundedDeque(BoundedDeque&& other) noexcept {
+        std::swap(_buffer, other._buffer);
+        std::swap(_head, other._head);
+        std::swap(_size, other._size);
+        std::swap(_capacity, other._capacity);
+        std::swap(_ring_capacity, other._ring_capacity);
+    }
+
+    ~BoundedDeque() {
+        clear();
+        deallocate(_buffer);
+    }
+
+    BoundedDeque& operator =(const BoundedDeque& other) {
+        if (this == &other)
+            return *this;
+        BoundedDeque temp(other);
+        return *this = std::move(temp);
+    }
+
+    BoundedDeque& operator =(BoundedDeque&& other) noexcept {
+        std::swap(_buffer, other._buffer);
+        std::swap(_head, other._head);
+        std::swap(_size, other._size);
+        std::swap(_capacity, other._capacity);
+        std::swap(_ring_capacity, other._ring_capacity);
+        return *this;
+    }
+
+    // Element access
+
+    T& at(size_t pos) {
+        if (!(pos < size())) {
+            throw std::out_of_range("BoundedDeque::out of range, pos(" + std::to_string(pos) + ") >= size (" + std::to_string(size()) + ")");
+        }
+        return (*this)[pos];
+    }
+
+    const T& at(size_t pos) const {
+        if (!(pos < size())) {
+            throw std::out_of_range("BoundedDeque::out of range, pos(" + std::to_string(pos) + ") >= size (" + std::to_string(size()) + ")");
+        }
+        return (*this)[pos];
+    }
+
+    T& operator [](size_t pos) {
+        return _buffer[wrap(_head + pos)];
+    }
+
+    const T& operator [](size_t pos) const {
+        return _buffer[wrap(_head + pos)];
+    }
+
+    T& front() {
+        return (*this)[0];
+    }
+
+    const T& front() const {
+        return (*this)[0];
+    }
+
+    T& back() {
+        return (*this)[size() - 1];
+    }
+
+    const T& back() const {
+        return (*this)[size() - 1];
+    }
+
+    // Contiguous storage
+
+    DequeSegments<T*> segments() {
+        size_t first_length = std::min(size(), _ring_capacity - _head);
+        DequeSegments<T*> result = {{_buffer + _head, first_length}, {_buffer, size() - first_length}};
+        return result;
+    }
+
+    DequeSegments<const T*> segments() const {
+        size_t first_length = std::min(size(), _ring_capacity - _head);
+        DequeSegments<const T*> result = {{_buffer + _head, first_length}, {_buffer, size() - first_length}};
+        return result;
+    }
+
+    // Capacity
+
+    bool empty() const {
+        return !size();
+    }
+
+    bool full() const {
+        return size() == _capacity;
+    }
+
+    size_t size() const {
+        return _size;
+    }
+
+    size_t capacity() const {
+        return _capacity;
+    }
+
+    // Modifiers
+
+    void clear() {
+        while (!empty())
+            pop_back();
+        _head = 0;
+    }
+
+    template <class... Args>
+    bool emplace_back(Args&&... args) {
+        if (full()) {
+            overwrite_back(std::forward<Args>(args)...);
+            return false;
+        }
+        construct(_buffer + wrap(_head + _size), std::forward<Args>(args)...);
+        ++_size;
+        return true;
+    }
+
+    bool push_back(const T& elem) {
+        return emplace_back(elem);
+    }
+
+    bool push_back(T&& elem) {
+        return emplace_back(std::move(elem));
+    }
+
+    void pop_back() {
+        --_size;
+        _buffer[wrap(_head + _size)].~T();
+    }
+
+    template <class... Args>
+    bool emplace_front(Args&&... args) {
+        if (full()) {
+            overwrite_front(std::forward<Args>(args)...);
+            return false;
+        }
+        size_t new_head = wrap(_head - 1);
+        construct(_buffer + new_head, std::forward<Args>(args)...);
+        _head = new_head;
+        ++_size;
+        return true;
+    }
+
+    bool push_front(const T& elem) {
+        return emplace_front(elem);
+    }
+
+    bool push_front(T&& elem) {
+        return emplace_front(std::move(elem));
+    }
+
+    void pop_front() {
+        _buffer[_head].~T();
+        _head = wrap(_head + 1);
+        --_size;
+    }
+
+    // Iterators
+
+    iterator begin() {
+        return iterator(this, 0);
+    }
+
+    const_iterator begin() const {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator cbegin() const {
+        return const_iterator(this, 0);
+    }
+
+    iterator end() {
+        return iterator(this, size());
+    }
+
+    const_iterator end() const {
+        return const_iterator(this, size());
+    }
+
+    const_iterator cend() const {
+        return const_iterator(this, size());
+    }
+
+    reverse_iterator rbegin() {
+        return reverse_iterator(end());
+    }
+
+    const_reverse_iterator rbegin() const {
+        return const_reverse_iterator(cend());
+    }
+
+    reverse_iterator rend() {
+        return reverse_iterator(begin());
+    }
+
+    const_reverse_iterator rend() const {
+        return const_reverse_iterator(cbegin());
+    }
+};
+
+#endif //DEQUE_BOUNDED_DEQUE_H
@@ -0,0 +1,266 @@
+//
+// Created by anton on 17.10.26.
+//
+
+#ifndef DEQUE_CONCURRENT_DEQUE_H
+#define DEQUE_CONCURRENT_DEQUE_H
+
+#include <stdexcept>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <utility>
+
+#include "deque.h"
+
+// Blocking queue for any number of threads: a Deque behind a mutex with two condition variables.
+//
+// Pushes block while a bounded deque is full and pops block while it is empty. After close()
+// pushes fail at once, and pops return the remaining elements and then fail instead of blocking.
+//
+// Waiters are counted, so a push or pop notifies only when somebody waits, and it does so after
+// unlocking. It wakes one waiter per element or free slot, never more than are waiting.
+//
+// Batches copy outside the lock. A batch push builds its chunk first and swaps it in if the deque is
+// empty; a batch pop that takes every element swaps the rings, into out directly if it is empty.
+// Passing the same, cleared, Deque to pop_batch every time recycles both buffers. A chunk pushed
+// onto a non-empty deque, and a pop that takes only some of the elements, still move that many
+// elements under the lock, since one ring cannot be split or joined without moving them.
+template <class T>
+class ConcurrentDeque {
+
+private:
+
+    mutable std::mutex _mutex;
+    std::condition_variable _not_empty;
+    std::condition_variable _not_full;
+
+    Deque<T> _dq;
+    size_t _capacity;
+    bool _closed = false;
+
+    size_t _waiting_consumers = 0;
+    size_t _waiting_producers = 0;
+
+    inline bool is_full() const {
+        return _dq.size() >= _capacity;
+    }
+
+    inline void wait_not_full(std::unique_lock<std::mutex>& lock) {
+        ++_waiting_producers;
+        _not_full.wait(lock, [this]() { return _closed || !is_full(); });
+        --_waiting_producers;
+    }
+
+    inline void wait_not_empty(std::unique_lock<std::mutex>& lock) {
+        ++_waiting_consumers;
+        _not_empty.wait(lock, [this]() { return _closed || !_dq.empty(); });
+        --_waiting_consumers;
+    }
+
+    // Unlocks, then wakes as many waiters as there are new elements (or free slots), if any wait
+    static void notify(std::unique_lock<std::mutex>& lock, std::condition_variable& cv, size_t waiting, size_t count) {
+        lock.unlock();
+        for (size_t woken = std::min(waiting, count); woken > 0; --woken)
+            cv.notify_one();
+    }
+
+    inline void notify_consumers(std::unique_lock<std::mutex>& lock, size_t pushed) {
+        notify(lock, _not_empty, _waiting_consumers, pushed);
+    }
+
+    inline void notify_producers(std::unique_lock<std::mutex>& lock, size_t popped) {
+        notify(lock, _not_full, _capacity == std::numeric_limits<size_t>::max() ? 0 : _waiting_producers, popped);
+    }
+
+    inline void pop_locked(T& out) {
+        out = std::move(_dq.front());
+        _dq.pop_front();
+    }
+
+    template <class U>
+    inline bool push_with(U&& elem) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (is_full() && !_closed)
+            wait_not_full(lock);
+        if (_closed)
+            return false;
+        _dq.push_back(std::forward<U>(elem));
+        notify_consumers(lock, 1);
+        return true;
+    }
+
+public:
+
+    // Constructors & destructors
+
+    // Unbounded, pushes never block
+    ConcurrentDeque() : _capacity(std::numeric_limits<size_t>::max()) {}
+
+    // Pushes block while capacity elements are queued
+    explicit ConcurrentDeque(size_t capacity) : _capacity(capacity) {
+        if (capacity == 0)
+            throw std::invalid_argument("ConcurrentDeque::capacity must be positive");
+    }
+
+    ConcurrentDeque(const ConcurrentDeque&) = delete;
+
+    ConcurrentDeque& operator =(const ConcurrentDeque&) = delete;
+
+    // Capacity
+
+    // May be outdated by the time it returns
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _dq.size();
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    // std::numeric_limits<size_t>::max() if unbounded
+    size_t capacity() const {
+        return _capacity;
+    }
+
+    // Modifiers
+
+    // Wakes all waiters; pushes fail from now on and pops fail once the deque is empty
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _closed = true;
+        }
+        _not_empty.notify_all();
+        _not_full.notify_all();
+    }
+
+    bool is_closed() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _closed;
+    }
+
+    // Producers
+
+    // Blocks while the deque is full. Returns false if it is closed.
+    bool push(const T& elem) {
+        return push_with(elem);
+    }
+
+    bool push(T&& elem) {
+        return push_with(std::move(elem));
+    }
+
+    // Fails instead of blocking
+    bool try_push(const T& elem) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (_closed || is_full())
+            return false;
+        _dq.push_back(elem);
+        notify_consumers(lock, 1);
+        return true;
+    }
+
+    // Appends [first, last) in as few locked chunks as the capacity allows, waiting for room between them.
+    // Returns the number of elements pushed, which is less than the size of the range only if closed.
+    template <class ForwardIt>
+    size_t push_batch(ForwardIt first, ForwardIt last) {
+        size_t remaining = std::distance(first, last);
+        size_t pushed = 0;
+        Deque<T> chunk;
+        while (remaining > 0 || !chunk.empty()) {
+            if (chunk.empty()) {
+                size_t count = std::min(remaining, _capacity);
+                ForwardIt chunk_end = std::next(first, count);
+                chunk.append(first, chunk_end);
+                first = chunk_end;
+                remaining -= count;
+            }
+            std::unique_lock<std::mutex> lock(_mutex);
+            if (is_full() && !_closed)
+                wait_not_full(lock);
+            if (_closed)
+                break;
+            size_t count = std::min(chunk.size(), _capacity - _dq.size());
+            bool swapped = count == chunk.size() && _dq.empty();
+            if (swapped)
+                _dq.swap(chunk);
+            else
+                _dq.append(std::make_move_iterator(chunk.begin()), std::make_move_iterator(chunk.begin() + count));
+            notify_consumers(lock, count);
+            if (!swapped)
+                chunk.erase(chunk.cbegin(), chunk.cbegin() + count);
+            pushed += count;
+        }
+        return pushed;
+    }
+
+    // Consumers
+
+    // Blocks while the deque is empty. Returns false if it is closed and empty.
+    bool pop(T& out) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (_dq.empty() && !_closed)
+            wait_not_empty(lock);
+        if (_dq.empty())
+            return false;
+        pop_locked(out);
+        notify_producers(lock, 1);
+        return true;
+    }
+
+    // Fails instead of blocking
+    bool try_pop(T& out) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (_dq.empty())
+            return false;
+        pop_locked(out);
+        notify_producers(lock, 1);
+        return true;
+    }
+
+    // Blocks for at most timeout while the deque is empty
+    template <class Rep, class Period>
+    bool wait_pop_for(T& out, const std::chrono::duration<Rep, Period>& timeout) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (_dq.empty() && !_closed) {
+            ++_waiting_consumers;
+            _not_empty.wait_for(lock, timeout, [this]() { return _closed || !_dq.empty(); });
+            --_waiting_consumers;
+        }
+        if (_dq.empty())
+            return false;
+        pop_locked(out);
+        notify_producers(lock, 1);
+        return true;
+    }
+
+    // Blocks while the deque is empty, then appends up to max elements to out from the front.
+    // Returns their number, 0 only if the deque is closed and empty.
+    size_t pop_batch(size_t max, Deque<T>& out) {
+        if (max == 0)
+            throw std::invalid_argument("ConcurrentDeque::pop_batch max must be positive");
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (_dq.empty() && !_closed)
+            wait_not_empty(lock);
+        size_t count = std::min(max, _dq.size());
+        Deque<T> taken;
+        if (count < _dq.size()) {
+            out.append(std::make_move_iterator(_dq.begin()), std::make_move_iterator(_dq.begin() + count));
+            _dq.erase(_dq.cbegin(), _dq.cbegin() + count);
+        } else if (out.empty()) {
+            _dq.swap(out);
+        } else {
+            _dq.swap(taken);
+        }
+        notify_producers(lock, count);
+        out.append(std::make_move_iterator(taken.begin()), std::make_move_iterator(taken.end()));
+        return count;
+    }
+};
+
+#endif //DEQUE_CONCURRENT_DEQUE_H
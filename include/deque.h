@@ -11,14 +11,38 @@
 #include <algorithm>
 #include <iterator>
 #include <iostream>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#define DEQUE_HAS_MEMORY_RESOURCE
+#endif
+#endif
 
 #include "deque_iterator.h"
+#include "deque_policy.h"
+#include "deque_segment.h"
 
-template <class T>
+template <class T, class Policy = DequeGrowthPolicy, class Allocator = std::allocator<T>>
 class Deque {
 
 private:
 
+    typedef std::allocator_traits<Allocator> alloc_traits;
+
+    static_assert(std::is_same<typename alloc_traits::value_type, T>::value,
+                  "Deque: Allocator::value_type must be T");
+    static_assert(std::is_same<typename alloc_traits::pointer, T*>::value,
+                  "Deque: Allocator must use raw pointers");
+
+    Allocator _allocator;
+
     T* _buffer = nullptr;
 
     size_t _head;
@@ -26,98 +50,671 @@ private:
     size_t _capacity;
     size_t _size;
 
-    const size_t DECREASE_CAPACITY_THRESHOLD = 4;
-    const size_t CHANGE_CAPACITY_RATIO = 2;
-    const size_t INITIAL_CAPACITY = 4;
+    static_assert(Policy::MIN_CAPACITY >= 2 && (Policy::MIN_CAPACITY & (Policy::MIN_CAPACITY - 1)) == 0,
+                  "Deque policy: MIN_CAPACITY must be a power of two");
+    static_assert(Policy::GROWTH_SHIFT > 0 && Policy::SHRINK_SHIFT > 0,
+                  "Deque policy: capacity must change on every resize");
+    static_assert(Policy::HYSTERESIS >= 2,
+                  "Deque policy: HYSTERESIS below 2 does not guarantee amortized O(1)");
+    static_assert(Policy::SHRINK_THRESHOLD >= (Policy::HYSTERESIS << Policy::GROWTH_SHIFT) &&
+                  Policy::SHRINK_THRESHOLD >= (Policy::HYSTERESIS << Policy::SHRINK_SHIFT),
+                  "Deque policy: SHRINK_THRESHOLD is too small for the hysteresis band");
 
-    inline void realloc(const size_t& new_capacity) {
-        T* temp_buffer = new T[new_capacity];
+    // Trivially copyable elements are relocated and copied with memcpy
+    typedef std::integral_constant<bool, std::is_trivially_copyable<T>::value> trivially_copyable;
+
+    inline T* allocate(size_t capacity) {
+        return alloc_traits::allocate(_allocator, capacity);
+    }
+
+    inline void deallocate(T* buffer, size_t capacity) {
+        alloc_traits::deallocate(_allocator, buffer, capacity);
+    }
+
+    template <class... Args>
+    inline void construct(T* place, Args&&... args) {
+        alloc_traits::construct(_allocator, place, std::forward<Args>(args)...);
+    }
+
+    inline void destroy(T* place) {
+        alloc_traits::destroy(_allocator, place);
+    }
+
+    inline void propagate_allocator(const Allocator& other, std::true_type) {
+        _allocator = other;
+    }
+
+    inline void propagate_allocator(const Allocator&, std::false_type) {}
+
+    inline void release_storage() {
+        if (_buffer != nullptr) {
+            destroy_elements();
+            deallocate(_buffer, _capacity);
+        }
+    }
+
+    // Takes over the buffer of other, which is left empty and without a buffer.
+    // The own buffer must be released before.
+    inline void steal_storage(Deque& other) {
+        _buffer = other._buffer;
+        _head = other._head;
+        _tail = other._tail;
+        _capacity = other._capacity;
+        _size = other._size;
+        other._buffer = nullptr;
+        other._head = 0;
+        other._tail = 0;
+        other._capacity = 0;
+        other._size = 0;
+    }
+
+    inline void move_elements_from(Deque& other, std::true_type) {
+        copy_elements_from(other, std::true_type());
+    }
+
+    inline void move_elements_from(Deque& other, std::false_type) {
+        for (size_t i = 0; i < other.size(); ++i) {
+            construct(_buffer + _tail, std::move(other[i]));
+            move_border_forward(_tail);
+            ++_size;
+        }
+    }
+
+    inline void move_assign(Deque& other, std::true_type) {
+        release_storage();
+        propagate_allocator(other._allocator, std::true_type());
+        steal_storage(other);
+    }
+
+    // Without propagation the buffer can only be taken over from an equal allocator
+    inline void move_assign(Deque& other, std::false_type) {
+        if (_allocator == other._allocator) {
+            release_storage();
+            steal_storage(other);
+            return;
+        }
+        Deque temp(std::move(other), _allocator);
+        release_storage();
+        steal_storage(temp);
+    }
+
+    // Pointers, vector iterators and, from C++20, any contiguous iterator; vector<bool> packs bits
+    template <class It>
+    struct is_contiguous_iterator : std::integral_constant<bool, std::is_pointer<It>::value ||
+#if __cplusplus >= 202002L
+            std::contiguous_iterator<It> ||
+#endif
+            (!std::is_same<T, bool>::value && (std::is_same<It, typename std::vector<T>::iterator>::value ||
+                                               std::is_same<It, typename std::vector<T>::const_iterator>::value))> {};
+
+    // Sources that are contiguous arrays of a trivially copyable T are copied with memcpy
+    template <class It>
+    struct is_memcpy_source : std::integral_constant<bool, trivially_copyable::value && is_contiguous_iterator<It>::value &&
+            std::is_same<typename std::remove_cv<typename std::iterator_traits<It>::value_type>::type, T>::value> {};
+
+    // Constructs count elements at dest from first, which is advanced past them.
+    // On exception the elements constructed so far are destroyed.
+    template <class ForwardIt>
+    inline void construct_range(T* dest, ForwardIt& first, size_t count, std::false_type) {
+        size_t constructed = 0;
+        try {
+            for (; constructed < count; ++constructed, ++first)
+                construct(dest + constructed, *first);
+        } catch (...) {
+            for (size_t i = 0; i < constructed; ++i)
+                destroy(dest + i);
+            throw;
+        }
+    }
+
+    template <class ContiguousIt>
+    inline void construct_range(T* dest, ContiguousIt& first, size_t count, std::true_type) {
+        if (count == 0)
+            return;
+        std::memcpy(static_cast<void*>(dest), std::addressof(*first), count * sizeof(T));
+        first += count;
+    }
+
+    // Fills count free slots starting at ring position start, at most two contiguous segments
+    template <class ForwardIt>
+    inline void construct_segments(size_t start, ForwardIt first, size_t count) {
+        size_t first_length = std::min(count, _capacity - start);
+        construct_range(_buffer + start, first, first_length, is_memcpy_source<ForwardIt>());
+        try {
+            construct_range(_buffer, first, count - first_length, is_memcpy_source<ForwardIt>());
+        } catch (...) {
+            for (size_t i = 0; i < first_length; ++i)
+                destroy(_buffer + start + i);
+            throw;
+        }
+    }
+
+    template <class InputIt>
+    inline void append_range(InputIt first, InputIt last, std::input_iterator_tag) {
+        for (; first != last; ++first)
+            emplace_back(*first);
+    }
+
+    template <class ForwardIt>
+    inline void append_range(ForwardIt first, ForwardIt last, std::forward_iterator_tag) {
+        size_t count = std::distance(first, last);
+        if (count == 0)
+            return;
+        reserve(size() + count);
+        construct_segments(_tail, first, count);
+        _tail = wrap(_tail + count);
+        _size += count;
+    }
 
+    template <class InputIt>
+    inline void prepend_range(InputIt first, InputIt last, std::input_iterator_tag) {
+        Deque temp(_allocator);
+        temp.append(first, last);
+        for (; !temp.empty(); temp.pop_back())
+            emplace_front(std::move(temp.back()));
+    }
+
+    template <class ForwardIt>
+    inline void prepend_range(ForwardIt first, ForwardIt last, std::forward_iterator_tag) {
+        size_t count = std::distance(first, last);
+        if (count == 0)
+            return;
+        reserve(size() + count);
+        size_t new_head = wrap(_head - count);
+        construct_segments(new_head, first, count);
+        _head = new_head;
+        _size += count;
+    }
+
+    // Moves count elements from ring position from to ring position to. When from_start is set
+    // the first element is moved first, so the ranges may overlap in the same way as for memmove.
+    inline void move_within(size_t to, size_t from, size_t count, bool from_start, std::true_type) {
+        if (from_start) {
+            while (count > 0) {
+                size_t chunk = std::min(count, std::min(_capacity - from, _capacity - to));
+                std::memmove(static_cast<void*>(_buffer + to), _buffer + from, chunk * sizeof(T));
+                to = wrap(to + chunk);
+                from = wrap(from + chunk);
+                count -= chunk;
+            }
+            return;
+        }
+        // Ends of the ranges, _capacity instead of 0 for a range ending at the end of the buffer
+        size_t to_end = wrap(to + count - 1) + 1;
+        size_t from_end = wrap(from + count - 1) + 1;
+        while (count > 0) {
+            size_t chunk = std::min(count, std::min(to_end, from_end));
+            to_end -= chunk;
+            from_end -= chunk;
+            std::memmove(static_cast<void*>(_buffer + to_end), _buffer + from_end, chunk * sizeof(T));
+            if (to_end == 0)
+                to_end = _capacity;
+            if (from_end == 0)
+                from_end = _capacity;
+            count -= chunk;
+        }
+    }
+
+    inline void move_within(size_t to, size_t from, size_t count, bool from_start, std::false_type) {
+        if (from_start) {
+            for (size_t i = 0; i < count; ++i)
+                _buffer[wrap(to + i)] = std::move(_buffer[wrap(from + i)]);
+        } else {
+            for (size_t i = count; i > 0; --i)
+                _buffer[wrap(to + i - 1)] = std::move(_buffer[wrap(from + i - 1)]);
+        }
+    }
+
+    // Opens count slots at logical index by shifting the shorter side and returns the ring
+    // position of the first one. The slots are counted in size() but left unconstructed,
+    // which is only valid for trivially copyable T.
+    inline size_t open_gap(size_t index, size_t count) {
+        reserve(size() + count);
+        if (index < size() - index) {
+            size_t new_head = wrap(_head - count);
+            move_within(new_head, _head, index, true, std::true_type());
+            _head = new_head;
+        } else {
+            move_within(wrap(_head + index + count), wrap(_head + index), size() - index, false, std::true_type());
+            _tail = wrap(_tail + count);
+        }
+        _size += count;
+        return wrap(_head + index);
+    }
+
+    template <class ForwardIt>
+    inline void insert_range(size_t index, ForwardIt first, ForwardIt last, std::true_type) {
+        size_t count = std::distance(first, last);
+        if (count == 0)
+            return;
+        construct_segments(open_gap(index, count), first, count);
+    }
+
+    // The range is added at the nearer end and rotated into place
+    template <class InputIt>
+    inline void insert_range(size_t index, InputIt first, InputIt last, std::false_type) {
         size_t old_size = size();
-        _tail = size();
+        if (index < old_size - index) {
+            prepend(first, last);
+            size_t count = size() - old_size;
+            std::rotate(begin(), begin() + count, begin() + count + index);
+        } else {
+            append(first, last);
+            std::rotate(begin() + index, begin() + old_size, end());
+        }
+    }
 
-        for (size_t i = 0; i < old_size; ++i) {
-            temp_buffer[i] = _buffer[_head];
-            move_border_forward(_head);
+    template <class... Args>
+    inline void emplace_at(size_t index, std::true_type, Args&&... args) {
+        T elem(std::forward<Args>(args)...);
+        size_t slot = open_gap(index, 1);
+        construct(_buffer + slot, elem);
+    }
+
+    template <class... Args>
+    inline void emplace_at(size_t index, std::false_type, Args&&... args) {
+        if (index < size() - index) {
+            emplace_front(std::forward<Args>(args)...);
+            std::rotate(begin(), begin() + 1, begin() + 1 + index);
+        } else {
+            emplace_back(std::forward<Args>(args)...);
+            std::rotate(begin() + index, end() - 1, end());
         }
+    }
 
-        delete[] _buffer;
-        _buffer = temp_buffer;
+    // Constructs count elements from the same arguments at ring position start.
+    // On exception the elements constructed so far are destroyed.
+    template <class... Args>
+    inline void construct_fill(size_t start, size_t count, const Args&... args) {
+        size_t constructed = 0;
+        try {
+            for (; constructed < count; ++constructed)
+                construct(_buffer + wrap(start + constructed), args...);
+        } catch (...) {
+            destroy_segments(start, constructed);
+            throw;
+        }
+    }
+
+    inline void erase_back(size_t count) {
+        size_t start = wrap(_tail - count);
+        destroy_segments(start, count);
+        _tail = start;
+        _size -= count;
+        try_to_decrease_capacity_after_bulk_pop();
+    }
+
+    inline void erase_front(size_t count) {
+        destroy_segments(_head, count);
+        _head = wrap(_head + count);
+        _size -= count;
+        try_to_decrease_capacity_after_bulk_pop();
+    }
+
+    template <class... Args>
+    inline void resize_back_with(size_t new_size, const Args&... args) {
+        if (new_size <= size()) {
+            erase_back(size() - new_size);
+            return;
+        }
+        size_t count = new_size - size();
+        reserve(new_size);
+        construct_fill(_tail, count, args...);
+        _tail = wrap(_tail + count);
+        _size = new_size;
+    }
+
+    template <class... Args>
+    inline void resize_front_with(size_t new_size, const Args&... args) {
+        if (new_size <= size()) {
+            erase_front(size() - new_size);
+            return;
+        }
+        size_t count = new_size - size();
+        reserve(new_size);
+        size_t new_head = wrap(_head - count);
+        construct_fill(new_head, count, args...);
+        _head = new_head;
+        _size = new_size;
+    }
+
+    // Trivially default constructible elements are left uninitialized
+    inline void resize_back_for_overwrite(size_t new_size, std::true_type) {
+        if (new_size <= size()) {
+            erase_back(size() - new_size);
+            return;
+        }
+        reserve(new_size);
+        _tail = wrap(_tail + new_size - size());
+        _size = new_size;
+    }
+
+    inline void resize_back_for_overwrite(size_t new_size, std::false_type) {
+        resize_back_with(new_size);
+    }
+
+    inline void resize_front_for_overwrite(size_t new_size, std::true_type) {
+        if (new_size <= size()) {
+            erase_front(size() - new_size);
+            return;
+        }
+        reserve(new_size);
+        _head = wrap(_head - (new_size - size()));
+        _size = new_size;
+    }
+
+    inline void resize_front_for_overwrite(size_t new_size, std::false_type) {
+        resize_front_with(new_size);
+    }
 
+    // Trivially copyable elements: the shorter run is copied out, the longer one is moved
+    // to its final place and the shorter one is copied back, so free slots are never touched
+    inline void linearize(std::true_type) {
+        size_t first_length = _capacity - _head;
+        size_t second_length = size() - first_length;
+        size_t shorter = std::min(first_length, second_length);
+        T* temp_buffer = allocate(shorter);
+        if (second_length <= first_length) {
+            std::memcpy(static_cast<void*>(temp_buffer), _buffer, shorter * sizeof(T));
+            std::memmove(static_cast<void*>(_buffer), _buffer + _head, first_length * sizeof(T));
+            std::memcpy(static_cast<void*>(_buffer + first_length), temp_buffer, shorter * sizeof(T));
+        } else {
+            std::memcpy(static_cast<void*>(temp_buffer), _buffer + _head, shorter * sizeof(T));
+            std::memmove(static_cast<void*>(_buffer + first_length), _buffer, second_length * sizeof(T));
+            std::memcpy(static_cast<void*>(_buffer), temp_buffer, shorter * sizeof(T));
+        }
+        deallocate(temp_buffer, shorter);
         _head = 0;
+        _tail = wrap(size());
+    }
+
+    // Other elements are relocated into a fresh buffer of the same capacity
+    inline void linearize(std::false_type) {
+        realloc(_capacity);
+    }
+
+    inline void swap_allocator(Deque& other, std::true_type) {
+        std::swap(_allocator, other._allocator);
+    }
+
+    inline void swap_allocator(Deque&, std::false_type) {}
+
+    inline void destroy_segments(size_t start, size_t count) {
+        if (std::is_trivially_destructible<T>::value)
+            return;
+        for (size_t i = 0; i < count; ++i) {
+            destroy(_buffer + start);
+            move_border_forward(start);
+        }
+    }
+
+    inline void destroy_elements() {
+        destroy_segments(_head, size());
+    }
+
+    // Moves count elements starting at ring position start to out, at most two contiguous runs.
+    // The moved-from elements are left in place.
+    template <class OutputIt>
+    inline OutputIt move_segments_out(size_t start, size_t count, OutputIt out) {
+        size_t first_length = std::min(count, _capacity - start);
+        out = std::move(_buffer + start, _buffer + start + first_length, out);
+        return std::move(_buffer, _buffer + (count - first_length), out);
+    }
+
+    // Copies the ring into dest as one contiguous run, at most two memcpy calls.
+    inline void copy_segments(T* dest) const {
+        if (empty())
+            return;
+        size_t first_length = std::min(size(), _capacity - _head);
+        std::memcpy(static_cast<void*>(dest), _buffer + _head, first_length * sizeof(T));
+        std::memcpy(static_cast<void*>(dest + first_length), _buffer, (size() - first_length) * sizeof(T));
+    }
+
+    inline void relocate_elements(T* temp_buffer, std::true_type) {
+        copy_segments(temp_buffer);
+    }
+
+    // Elements are moved into temp_buffer unless their move constructor may throw,
+    // in which case they are copied. On exception the deque is left untouched.
+    inline void relocate_elements(T* temp_buffer, std::false_type) {
+        size_t pos = _head;
+        size_t constructed = 0;
+
+        try {
+            for (; constructed < size(); ++constructed) {
+                construct(temp_buffer + constructed, std::move_if_noexcept(_buffer[pos]));
+                move_border_forward(pos);
+            }
+        } catch (...) {
+            for (size_t i = 0; i < constructed; ++i)
+                destroy(temp_buffer + i);
+            throw;
+        }
+    }
+
+    // On exception temp_buffer is still owned by the caller.
+    inline void relocate(T* temp_buffer, const size_t& new_capacity) {
+        relocate_elements(temp_buffer, trivially_copyable());
+
+        release_storage();
+        _buffer = temp_buffer;
 
         _capacity = new_capacity;
+
+        // A full ring wraps its tail back to slot 0
+        _head = 0;
+        _tail = wrap(size());
+    }
+
+    inline void copy_elements_from(const Deque& other, std::true_type) {
+        other.copy_segments(_buffer);
+        _tail = wrap(other.size());
+        _size = other.size();
+    }
+
+    inline void copy_elements_from(const Deque& other, std::false_type) {
+        for (size_t i = 0; i < other.size(); ++i) {
+            construct(_buffer + _tail, other[i]);
+            move_border_forward(_tail);
+            ++_size;
+        }
+    }
+
+    inline void realloc(const size_t& new_capacity) {
+        T* temp_buffer = allocate(new_capacity);
+        try {
+            relocate(temp_buffer, new_capacity);
+        } catch (...) {
+            deallocate(temp_buffer, new_capacity);
+            throw;
+        }
+    }
+
+    // The new element is built in the grown buffer before the old ones are relocated,
+    // so arguments referring to elements of this deque stay valid.
+    template <class... Args>
+    void grow_and_emplace(bool at_front, Args&&... args) {
+        size_t new_capacity = at_least_min_capacity(_capacity << Policy::GROWTH_SHIFT);
+        T* temp_buffer = allocate(new_capacity);
+        size_t slot = at_front ? new_capacity - 1 : size();
+
+        try {
+            construct(temp_buffer + slot, std::forward<Args>(args)...);
+        } catch (...) {
+            deallocate(temp_buffer, new_capacity);
+            throw;
+        }
+        try {
+            relocate(temp_buffer, new_capacity);
+        } catch (...) {
+            destroy(temp_buffer + slot);
+            deallocate(temp_buffer, new_capacity);
+            throw;
+        }
+
+        if (at_front)
+            _head = slot;
+        else
+            move_border_forward(_tail);
+        ++_size;
     }
 
     inline void try_to_decrease_capacity() {
-        if (!(size() < _capacity / DECREASE_CAPACITY_THRESHOLD) || _capacity < (INITIAL_CAPACITY << 1))
+        if (!(size() < _capacity / Policy::SHRINK_THRESHOLD) || _capacity <= Policy::MIN_CAPACITY)
             return;
-        realloc(_capacity >> CHANGE_CAPACITY_RATIO);
+        size_t new_capacity = _capacity >> Policy::SHRINK_SHIFT;
+        if (new_capacity < Policy::MIN_CAPACITY)
+            new_capacity = Policy::MIN_CAPACITY;
+        realloc(new_capacity);
     }
 
-    inline void try_to_increase_capacity() {
-        if (!(_head == (_tail + 1) % _capacity))
+    // A moved-from deque has no buffer at all and is always full
+    // Shrinks with a single reallocation as far as the same number of single pops would have
+    inline void try_to_decrease_capacity_after_bulk_pop() {
+        if (_buffer == nullptr)
             return;
-        realloc(_capacity << CHANGE_CAPACITY_RATIO);
+        size_t new_capacity = _capacity;
+        while (size() < new_capacity / Policy::SHRINK_THRESHOLD && new_capacity > Policy::MIN_CAPACITY)
+            new_capacity >>= Policy::SHRINK_SHIFT;
+        new_capacity = at_least_min_capacity(new_capacity);
+        if (new_capacity != _capacity)
+            realloc(new_capacity);
+    }
+
+    // Every slot of the ring is usable, size() tells a full ring from an empty one
+    inline bool is_full() const {
+        return _size == _capacity;
+    }
+
+    // _capacity is always a power of two, so positions wrap around with a mask
+    inline size_t wrap(size_t pos) const {
+        return pos & (_capacity - 1);
+    }
+
+    static size_t at_least_min_capacity(size_t capacity) {
+        return capacity < Policy::MIN_CAPACITY ? Policy::MIN_CAPACITY : capacity;
+    }
+
+    static size_t round_up_to_power_of_two(size_t val) {
+        size_t result = 1;
+        while (result < val)
+            result <<= 1;
+        return result;
     }
 
     inline void move_border_forward(size_t& val) const {
-        ++val;
-        if (val == _capacity)
-            val = 0;
+        val = wrap(val + 1);
     }
 
     inline void move_border_back(size_t& val) const {
-        if (val == 0)
-            val = _capacity - 1;
-        else
-            --val;
+        val = wrap(val - 1);
     }
 
 public:
 
     // Typedef iterators
 
-    typedef DequeIterator<T, T*, T&> iterator;
-    typedef DequeIterator<const T, const T*, const T&> const_iterator;
-    typedef std::reverse_iterator<DequeIterator<T, T*, T&>> reverse_iterator;
-    typedef std::reverse_iterator<DequeIterator<const T, const T*, const T&>> const_reverse_iterator;
+    typedef DequeIterator<Deque, T> iterator;
+    typedef DequeIterator<const Deque, const T> const_iterator;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
 
     // Constructors & destructors
 
-    Deque() {
-        _capacity = INITIAL_CAPACITY;
-        _buffer = new T[_capacity];
+    Deque() : Deque(Allocator()) {}
+
+    explicit Deque(const Allocator& allocator) : _allocator(allocator) {
+        _capacity = Policy::MIN_CAPACITY;
+        _buffer = allocate(_capacity);
         _head = 0;
         _tail = 0;
         _size = 0;
     }
 
-    Deque(const Deque& other) {
-        (*this) = other;
+    template <class InputIt>
+    Deque(InputIt first, InputIt last, const Allocator& allocator = Allocator()) : Deque(allocator) {
+        append(first, last);
+    }
+
+    Deque(std::initializer_list<T> elems, const Allocator& allocator = Allocator()) : Deque(allocator) {
+        append(elems.begin(), elems.end());
+    }
+
+    Deque(const Deque& other)
+            : Deque(other, alloc_traits::select_on_container_copy_construction(other._allocator)) {}
+
+    Deque(const Deque& other, const Allocator& allocator) : _allocator(allocator) {
+        _capacity = at_least_min_capacity(other._capacity);
+        _buffer = allocate(_capacity);
+        _head = 0;
+        _tail = 0;
+        _size = 0;
+        try {
+            copy_elements_from(other, trivially_copyable());
+        } catch (...) {
+            release_storage();
+            throw;
+        }
+    }
+
+    // The moved-from deque is left empty and does not own a buffer until the next insertion
+    Deque(Deque&& other) noexcept : _allocator(std::move(other._allocator)) {
+        steal_storage(other);
+    }
+
+    Deque(Deque&& other, const Allocator& allocator) : _allocator(allocator) {
+        if (_allocator == other._allocator) {
+            steal_storage(other);
+            return;
+        }
+        _capacity = at_least_min_capacity(other._capacity);
+        _buffer = allocate(_capacity);
+        _head = 0;
+        _tail = 0;
+        _size = 0;
+        try {
+            move_elements_from(other, trivially_copyable());
+        } catch (...) {
+            release_storage();
+            throw;
+        }
     }
 
     ~Deque() {
-        if (_buffer != nullptr)
-            delete[] _buffer;
+        release_storage();
     }
 
     Deque& operator =(const Deque& other) {
-        if (_buffer != nullptr)
-            delete[] _buffer;
-        if (other._buffer == nullptr) {
-            *this = Deque();
+        if (this == &other)
             return *this;
-        }
-        _buffer = new T[other._capacity];
-        std::copy(other._buffer, other._buffer + other._capacity, _buffer);
-        _head = other._head;
-        _tail = other._tail;
-        _capacity = other._capacity;
-        _size = other._size;
+        typedef typename alloc_traits::propagate_on_container_copy_assignment propagate;
+        Deque temp(other, propagate::value ? other._allocator : _allocator);
+        release_storage();
+        propagate_allocator(temp._allocator, propagate());
+        steal_storage(temp);
+        return *this;
+    }
+
+    Deque& operator =(Deque&& other) noexcept(alloc_traits::propagate_on_container_move_assignment::value) {
+        if (this == &other)
+            return *this;
+        move_assign(other, typename alloc_traits::propagate_on_container_move_assignment());
         return *this;
     }
 
+    void swap(Deque& other) noexcept {
+        swap_allocator(other, typename alloc_traits::propagate_on_container_swap());
+        std::swap(_buffer, other._buffer);
+        std::swap(_head, other._head);
+        std::swap(_tail, other._tail);
+        std::swap(_capacity, other._capacity);
+        std::swap(_size, other._size);
+    }
+
+    Allocator get_allocator() const {
+        return _allocator;
+    }
+
     // Element access
 
     T& at(size_t pos) {
@@ -135,11 +732,11 @@ public:
     }
 
     T& operator [](size_t pos) {
-        return _buffer[(_head + pos) % _capacity];
+        return _buffer[wrap(_head + pos)];
     }
 
     const T& operator [](size_t pos) const {
-        return _buffer[(_head + pos) % _capacity];
+        return _buffer[wrap(_head + pos)];
     }
 
     T& front() {
@@ -158,6 +755,28 @@ public:
         return (*this)[size() - 1];
     }
 
+    // Contiguous storage
+
+    DequeSegments<T*> segments() {
+        size_t first_length = std::min(size(), _capacity - _head);
+        DequeSegments<T*> result = {{_buffer + _head, first_length}, {_buffer, size() - first_length}};
+        return result;
+    }
+
+    DequeSegments<const T*> segments() const {
+        size_t first_length = std::min(size(), _capacity - _head);
+        DequeSegments<const T*> result = {{_buffer + _head, first_length}, {_buffer, size() - first_length}};
+        return result;
+    }
+
+    // Makes the elements one contiguous array and returns a pointer to the first one.
+    // Does nothing if they already are; otherwise invalidates iterators and references.
+    T* linearize() {
+        if (_head + size() > _capacity)
+            linearize(trivially_copyable());
+        return _buffer + _head;
+    }
+
     // Capacity
 
     bool empty() const {
@@ -168,68 +787,262 @@ public:
         return _size;
     }
 
+    // Number of elements the deque can hold before the next reallocation
+    size_t capacity() const {
+        return _capacity;
+    }
+
+    // Grows the ring once, so that new_capacity elements fit without intermediate reallocations.
+    // Never shrinks; popping below the shrink threshold may release the capacity again.
+    void reserve(size_t new_capacity) {
+        if (new_capacity <= capacity())
+            return;
+        realloc(at_least_min_capacity(round_up_to_power_of_two(new_capacity)));
+    }
+
     void shrink_to_fit() {
-        if (size() > INITIAL_CAPACITY && _capacity > size() + 1) {
-            realloc(size() + 1);
+        size_t fitted_capacity = round_up_to_power_of_two(size());
+        if (size() > Policy::MIN_CAPACITY && _capacity > fitted_capacity) {
+            realloc(fitted_capacity);
         }
     }
 
     // Modifiers
 
+    // Destroys the elements and keeps the buffer for the next fill
     void clear() {
-        (*this) = Deque();
+        destroy_elements();
+        _head = 0;
+        _tail = 0;
+        _size = 0;
     }
 
-    void push_back(const T& elem) {
-        try_to_increase_capacity();
-        _buffer[_tail] = elem;
+    template <class... Args>
+    T& emplace_back(Args&&... args) {
+        if (is_full()) {
+            grow_and_emplace(false, std::forward<Args>(args)...);
+            return back();
+        }
+        construct(_buffer + _tail, std::forward<Args>(args)...);
         ++_size;
         move_border_forward(_tail);
+        return back();
+    }
+
+    void push_back(const T& elem) {
+        emplace_back(elem);
+    }
+
+    void push_back(T&& elem) {
+        emplace_back(std::move(elem));
     }
 
     void pop_back() {
         try_to_decrease_capacity();
         --_size;
         move_border_back(_tail);
+        destroy(_buffer + _tail);
     }
 
-    void push_front(const T& elem) {
-        try_to_increase_capacity();
-        move_border_back(_head);
+    template <class... Args>
+    T& emplace_front(Args&&... args) {
+        if (is_full()) {
+            grow_and_emplace(true, std::forward<Args>(args)...);
+            return front();
+        }
+        size_t new_head = _head;
+        move_border_back(new_head);
+        construct(_buffer + new_head, std::forward<Args>(args)...);
+        _head = new_head;
         ++_size;
-        _buffer[_head] = elem;
+        return front();
+    }
+
+    void push_front(const T& elem) {
+        emplace_front(elem);
+    }
+
+    void push_front(T&& elem) {
+        emplace_front(std::move(elem));
     }
 
     void pop_front() {
         try_to_decrease_capacity();
         --_size;
+        destroy(_buffer + _head);
         move_border_forward(_head);
     }
 
+    // Resizes adjust the capacity at most once. Growing at the back appends elements,
+    // growing at the front prepends them; shrinking removes elements from the same side.
+
+    void resize(size_t new_size) {
+        resize_back_with(new_size);
+    }
+
+    void resize(size_t new_size, const T& value) {
+        if (new_size <= capacity()) {
+            resize_back_with(new_size, value);
+            return;
+        }
+        // value may be an element of this deque
+        T copy(value);
+        resize_back_with(new_size, copy);
+    }
+
+    void resize_for_overwrite(size_t new_size) {
+        resize_back_for_overwrite(new_size, std::is_trivially_default_constructible<T>());
+    }
+
+    void resize_front(size_t new_size) {
+        resize_front_with(new_size);
+    }
+
+    void resize_front(size_t new_size, const T& value) {
+        if (new_size <= capacity()) {
+            resize_front_with(new_size, value);
+            return;
+        }
+        T copy(value);
+        resize_front_with(new_size, copy);
+    }
+
+    void resize_front_for_overwrite(size_t new_size) {
+        resize_front_for_overwrite(new_size, std::is_trivially_default_constructible<T>());
+    }
+
+    // Bulk pops move up to two contiguous segments to out, update the ring once
+    // and check for shrinking once. They pop min(count, size()) elements.
+
+    template <class OutputIt>
+    OutputIt pop_front_n(size_t count, OutputIt out) {
+        count = std::min(count, size());
+        out = move_segments_out(_head, count, out);
+        destroy_segments(_head, count);
+        _head = wrap(_head + count);
+        _size -= count;
+        try_to_decrease_capacity_after_bulk_pop();
+        return out;
+    }
+
+    // The popped elements are written in their order in the deque, not in the order of pop_back()
+    template <class OutputIt>
+    OutputIt pop_back_n(size_t count, OutputIt out) {
+        count = std::min(count, size());
+        size_t start = wrap(_tail - count);
+        out = move_segments_out(start, count, out);
+        destroy_segments(start, count);
+        _tail = start;
+        _size -= count;
+        try_to_decrease_capacity_after_bulk_pop();
+        return out;
+    }
+
+    template <class OutputIt>
+    OutputIt drain_into(OutputIt out) {
+        return pop_front_n(size(), out);
+    }
+
+    // Grows at most once and writes the range into at most two contiguous segments of the ring
+
+    template <class InputIt>
+    void append(InputIt first, InputIt last) {
+        append_range(first, last, typename std::iterator_traits<InputIt>::iterator_category());
+    }
+
+    template <class InputIt>
+    void prepend(InputIt first, InputIt last) {
+        prepend_range(first, last, typename std::iterator_traits<InputIt>::iterator_category());
+    }
+
+    template <class InputIt>
+    void assign(InputIt first, InputIt last) {
+        clear();
+        append(first, last);
+    }
+
+    void assign(std::initializer_list<T> elems) {
+        assign(elems.begin(), elems.end());
+    }
+
+    // Middle insertions and erasures move the shorter side of the ring, so they cost
+    // O(min(index, size() - index)) plus the number of inserted or erased elements.
+    // Trivially copyable elements are shifted with memmove, others are added at the nearer
+    // end and rotated into place.
+
+    template <class InputIt>
+    iterator insert(const_iterator pos, InputIt first, InputIt last) {
+        size_t index = pos - cbegin();
+        typedef typename std::iterator_traits<InputIt>::iterator_category category;
+        insert_range(index, first, last, std::integral_constant<bool, trivially_copyable::value &&
+                std::is_base_of<std::forward_iterator_tag, category>::value>());
+        return begin() + index;
+    }
+
+    template <class... Args>
+    iterator emplace(const_iterator pos, Args&&... args) {
+        size_t index = pos - cbegin();
+        emplace_at(index, trivially_copyable(), std::forward<Args>(args)...);
+        return begin() + index;
+    }
+
+    iterator insert(const_iterator pos, const T& elem) {
+        return emplace(pos, elem);
+    }
+
+    iterator insert(const_iterator pos, T&& elem) {
+        return emplace(pos, std::move(elem));
+    }
+
+    iterator erase(const_iterator first, const_iterator last) {
+        size_t index = first - cbegin();
+        size_t count = last - first;
+        if (count == 0)
+            return begin() + index;
+        if (index < size() - index - count) {
+            move_within(wrap(_head + count), _head, index, false, trivially_copyable());
+            destroy_segments(_head, count);
+            _head = wrap(_head + count);
+        } else {
+            move_within(wrap(_head + index), wrap(_head + index + count), size() - index - count, true,
+                        trivially_copyable());
+            size_t start = wrap(_tail - count);
+            destroy_segments(start, count);
+            _tail = start;
+        }
+        _size -= count;
+        try_to_decrease_capacity_after_bulk_pop();
+        return begin() + index;
+    }
+
+    iterator erase(const_iterator pos) {
+        return erase(pos, pos + 1);
+    }
+
     // Iterators
 
     iterator begin() {
-        return iterator(_buffer, _capacity, _head, _tail, 0);
+        return iterator(this, 0);
     }
 
     const_iterator begin() const {
-        return const_iterator(_buffer, _capacity, _head, _tail, 0);
+        return const_iterator(this, 0);
     }
 
     const_iterator cbegin() const {
-        return const_iterator(_buffer, _capacity, _head, _tail, 0);
+        return const_iterator(this, 0);
     }
 
     iterator end() {
-        return iterator(_buffer, _capacity, _head, _tail, size());
+        return iterator(this, size());
     }
 
     const_iterator end() const {
-        return const_iterator(_buffer, _capacity, _head, _tail, size());
+        return const_iterator(this, size());
     }
 
     const_iterator cend() const {
-        return const_iterator(_buffer, _capacity, _head, _tail, size());
+        return const_iterator(this, size());
     }
 
     reverse_iterator rbegin() {
@@ -257,4 +1070,24 @@ public:
     }
 };
 
+template <class T, class Policy, class Allocator, class Predicate>
+size_t erase_if(Deque<T, Policy, Allocator>& dq, Predicate pred) {
+    typename Deque<T, Policy, Allocator>::iterator new_end = std::remove_if(dq.begin(), dq.end(), pred);
+    size_t removed = dq.end() - new_end;
+    dq.erase(new_end, dq.end());
+    return removed;
+}
+
+template <class T, class Policy, class Allocator>
+void swap(Deque<T, Policy, Allocator>& first, Deque<T, Policy, Allocator>& second) noexcept {
+    first.swap(second);
+}
+
+#ifdef DEQUE_HAS_MEMORY_RESOURCE
+namespace pmr {
+    template <class T, class Policy = DequeGrowthPolicy>
+    using Deque = ::Deque<T, Policy, std::pmr::polymorphic_allocator<T>>;
+}
+#endif
+
 #endif //DEQUE_DEQUE_H
\ No newline at end of file
@@ -0,0 +1,101 @@
+//
+// Created by anton on 17.10.26.
+//
+
+#ifndef DEQUE_DEQUE_ALGORITHM_H
+#define DEQUE_DEQUE_ALGORITHM_H
+
+#include <algorithm>
+#include <numeric>
+#include <utility>
+
+#include "deque_iterator.h"
+
+// Standard algorithms over DequeIterator ranges, run as plain pointer loops over the
+// at most two contiguous segments of the ring, so the compiler can vectorize them.
+// Every algorithm has a generic overload that forwards to std, so they can be used on any iterators.
+// DequeIndexIterator ranges (SegmentedDeque, IncrementalDeque) take the generic overloads.
+namespace segmented {
+
+    template <class InputIt, class OutputIt>
+    OutputIt copy(InputIt first, InputIt last, OutputIt out) {
+        return std::copy(first, last, out);
+    }
+
+    template <class Container, class Elem, class OutputIt>
+    OutputIt copy(DequeIterator<Container, Elem> first, DequeIterator<Container, Elem> last, OutputIt out) {
+        DequeSegments<Elem*> parts = first.segments_until(last);
+        out = std::copy(parts.first.begin(), parts.first.end(), out);
+        return std::copy(parts.second.begin(), parts.second.end(), out);
+    }
+
+    template <class ForwardIt, class Value>
+    void fill(ForwardIt first, ForwardIt last, const Value& value) {
+        std::fill(first, last, value);
+    }
+
+    template <class Container, class Elem, class Value>
+    void fill(DequeIterator<Container, Elem> first, DequeIterator<Container, Elem> last, const Value& value) {
+        DequeSegments<Elem*> parts = first.segments_until(last);
+        std::fill(parts.first.begin(), parts.first.end(), value);
+        std::fill(parts.second.begin(), parts.second.end(), value);
+    }
+
+    template <class InputIt, class Value>
+    InputIt find(InputIt first, InputIt last, const Value& value) {
+        return std::find(first, last, value);
+    }
+
+    template <class Container, class Elem, class Value>
+    DequeIterator<Container, Elem> find(DequeIterator<Container, Elem> first, DequeIterator<Container, Elem> last,
+                                        const Value& value) {
+        DequeSegments<Elem*> parts = first.segments_until(last);
+        Elem* found = std::find(parts.first.begin(), parts.first.end(), value);
+        if (found != parts.first.end())
+            return first + (found - parts.first.begin());
+        found = std::find(parts.second.begin(), parts.second.end(), value);
+        return first + (parts.first.size + (found - parts.second.begin()));
+    }
+
+    template <class InputIt, class Value>
+    Value accumulate(InputIt first, InputIt last, Value init) {
+        return std::accumulate(first, last, init);
+    }
+
+    template <class Container, class Elem, class Value>
+    Value accumulate(DequeIterator<Container, Elem> first, DequeIterator<Container, Elem> last, Value init) {
+        DequeSegments<Elem*> parts = first.segments_until(last);
+        init = std::accumulate(parts.first.begin(), parts.first.end(), init);
+        return std::accumulate(parts.second.begin(), parts.second.end(), init);
+    }
+
+    template <class InputIt, class Value, class BinaryOperation>
+    Value accumulate(InputIt first, InputIt last, Value init, BinaryOperation op) {
+        return std::accumulate(first, last, init, op);
+    }
+
+    template <class Container, class Elem, class Value, class BinaryOperation>
+    Value accumulate(DequeIterator<Container, Elem> first, DequeIterator<Container, Elem> last, Value init,
+                     BinaryOperation op) {
+        DequeSegments<Elem*> parts = first.segments_until(last);
+        init = std::accumulate(parts.first.begin(), parts.first.end(), init, op);
+        return std::accumulate(parts.second.begin(), parts.second.end(), init, op);
+    }
+
+    template <class InputIt1, class InputIt2>
+    bool equal(InputIt1 first1, InputIt1 last1, InputIt2 first2) {
+        return std::equal(first1, last1, first2);
+    }
+
+    template <class Container, class Elem, class InputIt2>
+    bool equal(DequeIterator<Container, Elem> first1, DequeIterator<Container, Elem> last1, InputIt2 first2) {
+        DequeSegments<Elem*> parts = first1.segments_until(last1);
+        // Continues from where the first segment stopped, so first2 may be single-pass
+        std::pair<Elem*, InputIt2> stop = std::mismatch(parts.first.begin(), parts.first.end(), first2);
+        if (stop.first != parts.first.end())
+            return false;
+        return std::equal(parts.second.begin(), parts.second.end(), stop.second);
+    }
+}
+
+#endif //DEQUE_DEQUE_ALGORITHM_H
@@ -5,136 +5,415 @@
 #ifndef DEQUE_DEQUE_ITERATOR_H
 #define DEQUE_DEQUE_ITERATOR_H
 
+#include <cstddef>
 #include <iterator>
+#include <algorithm>
+#include <type_traits>
 
-template <class T, class Pointer, class Reference>
-class DequeIterator : public std::iterator<std::random_access_iterator_tag, T> {
+#include "deque_segment.h"
+
+// Marks functions that can be evaluated at compile time starting from C++20
+#if __cplusplus >= 202002L
+#define DEQUE_CONSTEXPR20 constexpr
+#else
+#define DEQUE_CONSTEXPR20
+#endif
+
+// Random access iterator over a ring container with segments(), i.e. with its elements in
+// at most two contiguous runs of one buffer.
+//
+// The iterator is two words: a pointer to the container and a pointer into its buffer. An iterator
+// to an element points right at it, so dereferencing is a plain load and incrementing a pointer bump
+// with a rarely taken branch where the elements leave a segment. end() is the end of the first segment,
+// which is never an element, even in a full ring. Positions past end() continue from there and positions
+// before begin() lie before the buffer, so moving there (as reverse iterators and "it += step" loops do)
+// is fine as long as the iterator is not dereferenced. Ordering, distances and jumps take the segments
+// of the container to find the positions.
+//
+// As with std::vector, swap() and moves invalidate iterators, since they point into the storage.
+//
+// Container is const-qualified for const iterators, Value is the const-qualified element type.
+template <class Container, class Value>
+class DequeIterator {
+
+public:
+
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef typename std::remove_const<Value>::type value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef Value* pointer;
+    typedef Value& reference;
 
 private:
 
-    T* buffer;
-    int capacity;
-    int head;
-    int tail;
+    Container* _container;
+    pointer _ptr;
+
+    template <class OtherContainer, class OtherValue>
+    friend class DequeIterator;
+
+    template <class LeftContainer, class LeftValue, class RightContainer, class RightValue>
+    friend DEQUE_CONSTEXPR20 bool operator ==(const DequeIterator<LeftContainer, LeftValue>& lhs,
+                                              const DequeIterator<RightContainer, RightValue>& rhs);
+
+    template <class LeftContainer, class LeftValue, class RightContainer, class RightValue>
+    friend DEQUE_CONSTEXPR20 bool operator <(const DequeIterator<LeftContainer, LeftValue>& lhs,
+                                             const DequeIterator<RightContainer, RightValue>& rhs);
+
+    template <class LeftContainer, class LeftValue, class RightContainer, class RightValue>
+    friend DEQUE_CONSTEXPR20 std::ptrdiff_t operator -(const DequeIterator<LeftContainer, LeftValue>& lhs,
+                                                       const DequeIterator<RightContainer, RightValue>& rhs);
+
+    static DEQUE_CONSTEXPR20 pointer locate(const DequeSegments<pointer>& all, difference_type index) {
+        difference_type first_size = static_cast<difference_type>(all.first.size);
+        difference_type size = first_size + static_cast<difference_type>(all.second.size);
+        if (index < 0)
+            return all.second.data + index;
+        if (index < first_size)
+            return all.first.data + index;
+        if (index < size)
+            return all.second.data + (index - first_size);
+        return all.first.data + all.first.size + (index - size);
+    }
 
-    int current;
+    DEQUE_CONSTEXPR20 difference_type index_in(const DequeSegments<pointer>& all) const {
+        pointer first_end = all.first.data + all.first.size;
+        if (_ptr < all.second.data)
+            return _ptr - all.second.data;
+        if (_ptr >= first_end)
+            return static_cast<difference_type>(all.first.size + all.second.size) + (_ptr - first_end);
+        if (_ptr >= all.first.data)
+            return _ptr - all.first.data;
+        return static_cast<difference_type>(all.first.size) + (_ptr - all.second.data);
+    }
 
-    int position_in_buffer(int ind) const {
-        return (head + ind) % capacity;
+    DEQUE_CONSTEXPR20 difference_type index() const {
+        return index_in(_container->segments());
     }
 
 public:
 
-    DequeIterator() {}
+    DEQUE_CONSTEXPR20 DequeIterator() : _container(nullptr), _ptr(nullptr) {}
+
+    DEQUE_CONSTEXPR20 DequeIterator(Container* container, difference_type index)
+            : _container(container), _ptr(locate(container->segments(), index)) {}
+
+    // iterator converts to const_iterator
+    template <class OtherContainer, class OtherValue, class = typename std::enable_if<
+            std::is_convertible<OtherContainer*, Container*>::value &&
+            std::is_convertible<OtherValue*, Value*>::value>::type>
+    DEQUE_CONSTEXPR20 DequeIterator(const DequeIterator<OtherContainer, OtherValue>& other)
+            : _container(other._container), _ptr(other._ptr) {}
+
+    // Contiguous runs of the buffer covering [*this, last), at most two
+    DequeSegments<pointer> segments_until(const DequeIterator& last) const {
+        DequeSegments<pointer> all = _container->segments();
+        size_t from = static_cast<size_t>(index_in(all));
+        size_t to = static_cast<size_t>(last.index_in(all));
+        DequeSegments<pointer> result;
+        if (from < all.first.size) {
+            size_t first_end = std::min(to, all.first.size);
+            result.first.data = all.first.data + from;
+            result.first.size = first_end - from;
+            result.second.data = all.second.data;
+            result.second.size = to - first_end;
+        } else {
+            result.first.data = all.second.data + (from - all.first.size);
+            result.first.size = to - from;
+            result.second.data = all.second.data;
+            result.second.size = 0;
+        }
+        return result;
+    }
 
-    DequeIterator(T* buffer, int capacity, int head, int tail, int current) : buffer(buffer), capacity(capacity), head(head), tail(tail), current(current) {}
 
-    DequeIterator(const DequeIterator& other) {
-        (*this) = other;
+    DEQUE_CONSTEXPR20 reference operator *() const {
+        return *_ptr;
     }
 
-    DequeIterator& operator =(const DequeIterator& other) {
-        buffer = other.buffer;
-        capacity = other.capacity;
-        head = other.head;
-        tail = other.tail;
-        current = other.current;
+    DEQUE_CONSTEXPR20 pointer operator ->() const {
+        return _ptr;
+    }
+
+
+    DEQUE_CONSTEXPR20 DequeIterator& operator +=(difference_type shift) {
+        DequeSegments<pointer> all = _container->segments();
+        _ptr = locate(all, index_in(all) + shift);
         return *this;
     }
 
+    DEQUE_CONSTEXPR20 DequeIterator operator +(difference_type shift) const {
+        DequeIterator nw(*this);
+        nw += shift;
+        return nw;
+    }
 
-    bool operator ==(const DequeIterator& other) const {
-        return current == other.current;
+    DEQUE_CONSTEXPR20 DequeIterator& operator -=(difference_type shift) {
+        return *this += -shift;
+    }
+
+    DEQUE_CONSTEXPR20 DequeIterator operator -(difference_type shift) const {
+        DequeIterator nw(*this);
+        nw -= shift;
+        return nw;
     }
 
-    bool operator !=(const DequeIterator& other) const {
-        return !(*this == other);
+
+    DEQUE_CONSTEXPR20 DequeIterator& operator ++() {
+        DequeSegments<pointer> all = _container->segments();
+        ++_ptr;
+        if (all.second.size != 0 && _ptr == all.first.data + all.first.size)
+            _ptr = all.second.data;
+        else if (all.second.size != 0 && _ptr == all.second.data + all.second.size)
+            _ptr = all.first.data + all.first.size;
+        else if (_ptr == all.second.data)
+            _ptr = all.first.data;
+        return *this;
     }
 
-    bool operator <(const DequeIterator& other) const {
-        return current < other.current;
+    DEQUE_CONSTEXPR20 DequeIterator operator ++(int) {
+        DequeIterator nw(*this);
+        ++*this;
+        return nw;
     }
 
-    bool operator >(const DequeIterator& other) const {
-        return current > other.current;
+    DEQUE_CONSTEXPR20 DequeIterator& operator --() {
+        DequeSegments<pointer> all = _container->segments();
+        if (all.second.size != 0 && _ptr == all.first.data + all.first.size)
+            _ptr = all.second.data + all.second.size;
+        else if (all.second.size != 0 && _ptr == all.second.data)
+            _ptr = all.first.data + all.first.size;
+        else if (_ptr == all.first.data)
+            _ptr = all.second.data;
+        --_ptr;
+        return *this;
     }
 
-    bool operator <=(const DequeIterator& other) const {
-        return !(*this > other);
+    DEQUE_CONSTEXPR20 DequeIterator operator --(int) {
+        DequeIterator nw(*this);
+        --*this;
+        return nw;
     }
 
-    bool operator >=(const DequeIterator& other) const {
-        return !(*this < other);
+
+    DEQUE_CONSTEXPR20 reference operator [](difference_type shift) const {
+        return *(*this + shift);
     }
 
+};
+
+// Comparisons and distances also mix iterators with const_iterators
+
+template <class LeftContainer, class LeftValue, class RightContainer, class RightValue>
+DEQUE_CONSTEXPR20 bool operator ==(const DequeIterator<LeftContainer, LeftValue>& lhs,
+                                   const DequeIterator<RightContainer, RightValue>& rhs) {
+    return lhs._ptr == rhs._ptr;
+}
+
+template <class LeftContainer, class LeftValue, class RightContainer, class RightValue>
+DEQUE_CONSTEXPR20 bool operator !=(const DequeIterator<LeftContainer, LeftValue>& lhs,
+                                   const DequeIterator<RightContainer, RightValue>& rhs) {
+    return !(lhs == rhs);
+}
+
+template <class LeftContainer, class LeftValue, class RightContainer, class RightValue>
+DEQUE_CONSTEXPR20 bool operator <(const DequeIterator<LeftContainer, LeftValue>& lhs,
+                                  const DequeIterator<RightContainer, RightValue>& rhs) {
+    return lhs.index() < rhs.index();
+}
+
+template <class LeftContainer, class LeftValue, class RightContainer, class RightValue>
+DEQUE_CONSTEXPR20 bool operator >(const DequeIterator<LeftContainer, LeftValue>& lhs,
+                                  const DequeIterator<RightContainer, RightValue>& rhs) {
+    return rhs < lhs;
+}
+
+template <class LeftContainer, class LeftValue, class RightContainer, class RightValue>
+DEQUE_CONSTEXPR20 bool operator <=(const DequeIterator<LeftContainer, LeftValue>& lhs,
+                                   const DequeIterator<RightContainer, RightValue>& rhs) {
+    return !(rhs < lhs);
+}
+
+template <class LeftContainer, class LeftValue, class RightContainer, class RightValue>
+DEQUE_CONSTEXPR20 bool operator >=(const DequeIterator<LeftContainer, LeftValue>& lhs,
+                                   const DequeIterator<RightContainer, RightValue>& rhs) {
+    return !(lhs < rhs);
+}
+
+template <class LeftContainer, class LeftValue, class RightContainer, class RightValue>
+DEQUE_CONSTEXPR20 std::ptrdiff_t operator -(const DequeIterator<LeftContainer, LeftValue>& lhs,
+                                            const DequeIterator<RightContainer, RightValue>& rhs) {
+    return lhs.index() - rhs.index();
+}
+
+template <class Container, class Value>
+DEQUE_CONSTEXPR20 DequeIterator<Container, Value> operator +(
+        typename DequeIterator<Container, Value>::difference_type shift, const DequeIterator<Container, Value>& it) {
+    return it + shift;
+}
+
+// Random access iterator over any container with operator[], for containers whose elements
+// are not in two runs of one buffer (SegmentedDeque, IncrementalDeque).
+//
+// The iterator is two words: a pointer to the container and a signed logical index. Dereferencing
+// goes through the container's operator[], so the iterator never caches buffer, head or capacity,
+// and moving it before begin() or past end() stays well defined as long as it is not dereferenced there.
+//
+// Since it points to the container object, not to its storage, an iterator keeps referring to
+// the same position of the same object after swap() or a move: unlike std containers, it does not
+// follow the elements into the other object.
+template <class Container, class Value>
+class DequeIndexIterator {
+
+public:
+
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef typename std::remove_const<Value>::type value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef Value* pointer;
+    typedef Value& reference;
+
+private:
+
+    Container* _container;
+    difference_type _index;
+
+    template <class OtherContainer, class OtherValue>
+    friend class DequeIndexIterator;
+
+    template <class LeftContainer, class LeftValue, class RightContainer, class RightValue>
+    friend bool operator ==(const DequeIndexIterator<LeftContainer, LeftValue>& lhs,
+                            const DequeIndexIterator<RightContainer, RightValue>& rhs);
+
+    template <class LeftContainer, class LeftValue, class RightContainer, class RightValue>
+    friend bool operator <(const DequeIndexIterator<LeftContainer, LeftValue>& lhs,
+                           const DequeIndexIterator<RightContainer, RightValue>& rhs);
+
+    template <class LeftContainer, class LeftValue, class RightContainer, class RightValue>
+    friend std::ptrdiff_t operator -(const DequeIndexIterator<LeftContainer, LeftValue>& lhs,
+                                     const DequeIndexIterator<RightContainer, RightValue>& rhs);
+
+public:
+
+    DequeIndexIterator() : _container(nullptr), _index(0) {}
 
-    Reference operator *() {
-        return *(buffer + position_in_buffer(current));
+    DequeIndexIterator(Container* container, difference_type index) : _container(container), _index(index) {}
+
+    // iterator converts to const_iterator
+    template <class OtherContainer, class OtherValue, class = typename std::enable_if<
+            std::is_convertible<OtherContainer*, Container*>::value &&
+            std::is_convertible<OtherValue*, Value*>::value>::type>
+    DequeIndexIterator(const DequeIndexIterator<OtherContainer, OtherValue>& other)
+            : _container(other._container), _index(other._index) {}
+
+
+    reference operator *() const {
+        return (*_container)[static_cast<size_t>(_index)];
     }
 
-    Pointer operator ->() {
+    pointer operator ->() const {
         return &**this;
     }
 
 
-    DequeIterator& operator +=(int shift) {
-        current += shift;
+    DequeIndexIterator& operator +=(difference_type shift) {
+        _index += shift;
         return *this;
     }
 
-    DequeIterator operator +(int shift) const {
-        DequeIterator nw(*this);
+    DequeIndexIterator operator +(difference_type shift) const {
+        DequeIndexIterator nw(*this);
         nw += shift;
         return nw;
     }
 
-    DequeIterator& operator -=(int shift) {
-        current -= shift;
+    DequeIndexIterator& operator -=(difference_type shift) {
+        _index -= shift;
         return *this;
     }
 
-    DequeIterator operator -(int shift) const {
-        DequeIterator nw(*this);
+    DequeIndexIterator operator -(difference_type shift) const {
+        DequeIndexIterator nw(*this);
         nw -= shift;
         return nw;
     }
 
 
-    DequeIterator& operator ++() {
-        *this += 1;
+    DequeIndexIterator& operator ++() {
+        ++_index;
         return *this;
     }
 
-    DequeIterator operator ++(int) {
-        DequeIterator nw(*this);
+    DequeIndexIterator operator ++(int) {
+        DequeIndexIterator nw(*this);
         ++*this;
         return nw;
     }
 
-    DequeIterator& operator --() {
-        *this -= 1;
+    DequeIndexIterator& operator --() {
+        --_index;
         return *this;
     }
 
-    DequeIterator operator --(int) {
-        DequeIterator nw(*this);
+    DequeIndexIterator operator --(int) {
+        DequeIndexIterator nw(*this);
         --*this;
         return nw;
     }
 
 
-    int operator -(const DequeIterator& other) const {
-        return current - other.current;
-    }
-
-    Reference operator [](int shift) {
+    reference operator [](difference_type shift) const {
         return *(*this + shift);
     }
 
 };
 
-template <class T, class Pointer, class Reference>
-DequeIterator<T, Pointer, Reference> operator +(int shift, const DequeIterator<T, Pointer, Reference>& it) {
+template <class LeftContainer, class LeftValue, class RightContainer, class RightValue>
+bool operator ==(const DequeIndexIterator<LeftContainer, LeftValue>& lhs,
+                 const DequeIndexIterator<RightContainer, RightValue>& rhs) {
+    return lhs._index == rhs._index;
+}
+
+template <class LeftContainer, class LeftValue, class RightContainer, class RightValue>
+bool operator !=(const DequeIndexIterator<LeftContainer, LeftValue>& lhs,
+                 const DequeIndexIterator<RightContainer, RightValue>& rhs) {
+    return !(lhs == rhs);
+}
+
+template <class LeftContainer, class LeftValue, class RightContainer, class RightValue>
+bool operator <(const DequeIndexIterator<LeftContainer, LeftValue>& lhs,
+                const DequeIndexIterator<RightContainer, RightValue>& rhs) {
+    return lhs._index < rhs._index;
+}
+
+template <class LeftContainer, class LeftValue, class RightContainer, class RightValue>
+bool operator >(const DequeIndexIterator<LeftContainer, LeftValue>& lhs,
+                const DequeIndexIterator<RightContainer, RightValue>& rhs) {
+    return rhs < lhs;
+}
+
+template <class LeftContainer, class LeftValue, class RightContainer, class RightValue>
+bool operator <=(const DequeIndexIterator<LeftContainer, LeftValue>& lhs,
+                 const DequeIndexIterator<RightContainer, RightValue>& rhs) {
+    return !(rhs < lhs);
+}
+
+template <class LeftContainer, class LeftValue, class RightContainer, class RightValue>
+bool operator >=(const DequeIndexIterator<LeftContainer, LeftValue>& lhs,
+                 const DequeIndexIterator<RightContainer, RightValue>& rhs) {
+    return !(lhs < rhs);
+}
+
+template <class LeftContainer, class LeftValue, class RightContainer, class RightValue>
+std::ptrdiff_t operator -(const DequeIndexIterator<LeftContainer, LeftValue>& lhs,
+                          const DequeIndexIterator<RightContainer, RightValue>& rhs) {
+    return lhs._index - rhs._index;
+}
+
+template <class Container, class Value>
+DequeIndexIterator<Container, Value> operator +(
+        typename DequeIndexIterator<Container, Value>::difference_type shift,
+        const DequeIndexIterator<Container, Value>& it) {
     return it + shift;
 }
 
@@ -0,0 +1,46 @@
+//
+// Created by anton on 17.10.26.
+//
+
+#ifndef DEQUE_DEQUE_POLICY_H
+#define DEQUE_DEQUE_POLICY_H
+
+#include <cstddef>
+
+// Growth policy of Deque. Capacities are powers of two, so the factors are given as shifts.
+//
+// Right after growing the ring is 1 / 2^GROWTH_SHIFT full, and right after shrinking it is
+// less than 2^SHRINK_SHIFT / SHRINK_THRESHOLD full. Both points must stay at least
+// HYSTERESIS times away from the load factor that triggers the opposite resize,
+// otherwise alternating push/pop at a boundary reallocates on every operation.
+struct DequeGrowthPolicy {
+    // Capacity of a new deque, the deque never shrinks below it
+    static const size_t MIN_CAPACITY = 4;
+
+    // Capacity is multiplied by 2^GROWTH_SHIFT when the ring is full
+    static const size_t GROWTH_SHIFT = 1;
+
+    // Minimal ratio between the load factor after a resize and the one triggering the next resize
+    static const size_t HYSTERESIS = 2;
+
+    // Capacity is divided by 2^SHRINK_SHIFT once size() < capacity / SHRINK_THRESHOLD,
+    // the smallest threshold that keeps both resizes HYSTERESIS away from each other
+    static const size_t SHRINK_SHIFT = 1;
+    static const size_t SHRINK_THRESHOLD = HYSTERESIS << (GROWTH_SHIFT > SHRINK_SHIFT ? GROWTH_SHIFT : SHRINK_SHIFT);
+};
+
+// What a fixed-capacity deque does with an element pushed into a full ring
+enum DequeOverflowPolicy {
+    // Throw std::length_error, the deque is left unchanged
+    DEQUE_OVERFLOW_THROW,
+    // Drop the new element, the push returns false
+    DEQUE_OVERFLOW_FAIL,
+    // Evict the element at the opposite end to make room, the push returns false
+    DEQUE_OVERFLOW_OVERWRITE
+};
+
+// Alignment of the indices of concurrent deques: data written by different threads is kept
+// on different cache lines, so that the threads do not invalidate each other's caches
+#define DEQUE_CACHE_LINE_SIZE 64
+
+#endif //DEQUE_DEQUE_POLICY_H
@@ -0,0 +1,37 @@
+//
+// Created by anton on 17.10.26.
+//
+
+#ifndef DEQUE_DEQUE_SEGMENT_H
+#define DEQUE_DEQUE_SEGMENT_H
+
+#include <cstddef>
+
+// A contiguous run of elements inside the ring buffer of a deque
+template <class Pointer>
+struct DequeSegment {
+    Pointer data;
+    size_t size;
+
+    Pointer begin() const {
+        return data;
+    }
+
+    Pointer end() const {
+        return data + size;
+    }
+
+    bool empty() const {
+        return size == 0;
+    }
+};
+
+// The contents of a ring buffer, in order: first, then second. Only the second one may be empty
+// when the deque is not, and second.data always points to the start of the buffer.
+template <class Pointer>
+struct DequeSegments {
+    DequeSegment<Pointer> first;
+    DequeSegment<Pointer> second;
+};
+
+#endif //DEQUE_DEQUE_SEGMENT_H
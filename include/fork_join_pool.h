@@ -0,0 +1,245 @@
+//
+// Created by anton on 17.10.26.
+//
+
+#ifndef DEQUE_FORK_JOIN_POOL_H
+#define DEQUE_FORK_JOIN_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "deque.h"
+#include "work_stealing_deque.h"
+
+enum ForkJoinScheduling {
+    FORK_JOIN_WORK_STEALING,    // each worker pushes to and pops from its own WorkStealingDeque, idle workers steal
+    FORK_JOIN_GLOBAL_QUEUE      // every task goes through one Deque behind a mutex, for comparison
+};
+
+// Small fork-join thread pool.
+//
+// run() hands a task to the pool and returns when it and everything it spawned have finished.
+// Inside a task, a TaskGroup spawns subtasks and waits for them; a waiting thread runs other tasks
+// instead of blocking, so recursion as deep as the tasks go needs no more threads than the pool has.
+//
+// A worker spawns onto the back of its own deque and pops from there too, so it runs the newest,
+// cache-hot task first, while idle workers steal the oldest, usually largest, task from the front.
+// Tasks from outside the pool go through a Deque behind a mutex. Tasks must not throw.
+class ForkJoinPool {
+
+private:
+
+    struct Task {
+        std::function<void()> work;
+        std::atomic<size_t>* pending;
+    };
+
+    struct Worker {
+        ForkJoinPool* pool;
+        WorkStealingDeque<Task*> tasks;
+        std::thread thread;
+
+        explicit Worker(ForkJoinPool* pool) : pool(pool) {}
+
+        // Plain new ignores the cache-line alignment of the deque indices before C++17,
+        // so the block is over-allocated and the original pointer is kept just before the object
+        static void* operator new(size_t bytes) {
+            void* raw = ::operator new(bytes + alignof(Worker) + sizeof(void*));
+            uintptr_t start = reinterpret_cast<uintptr_t>(raw) + sizeof(void*);
+            uintptr_t aligned = (start + alignof(Worker) - 1) & ~static_cast<uintptr_t>(alignof(Worker) - 1);
+            reinterpret_cast<void**>(aligned)[-1] = raw;
+            return reinterpret_cast<void*>(aligned);
+        }
+
+        static void operator delete(void* place) {
+            if (place != nullptr)
+                ::operator delete(static_cast<void**>(place)[-1]);
+        }
+    };
+
+    ForkJoinScheduling _scheduling;
+    std::vector<std::unique_ptr<Worker>> _workers;
+
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    Deque<Task*> _injected;
+    std::atomic<size_t> _injected_size;
+
+    // Workers sleep on _wake while no run() is in progress
+    std::atomic<size_t> _active_runs;
+    std::atomic<bool> _stopping;
+
+    static Worker*& current_worker() {
+        static thread_local Worker* worker = nullptr;
+        return worker;
+    }
+
+    inline Worker* current() const {
+        Worker* worker = current_worker();
+        return worker != nullptr && worker->pool == this ? worker : nullptr;
+    }
+
+    inline void submit(Task* task) {
+        Worker* self = current();
+        if (_scheduling == FORK_JOIN_WORK_STEALING && self != nullptr) {
+            self->tasks.push_back(task);
+            return;
+        }
+        std::lock_guard<std::mutex> lock(_mutex);
+        _injected.push_back(task);
+        _injected_size.store(_injected.size(), std::memory_order_release);
+    }
+
+    inline bool pop_injected(Task*& task) {
+        if (_injected_size.load(std::memory_order_acquire) == 0)
+            return false;
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_injected.empty())
+            return false;
+        task = _injected.front();
+        _injected.pop_front();
+        _injected_size.store(_injected.size(), std::memory_order_release);
+        return true;
+    }
+
+    // Victims are tried in order from a per-thread random start
+    inline bool steal(Worker* self, Task*& task) {
+        static thread_local unsigned seed = static_cast<unsigned>(std::hash<std::thread::id>()(std::this_thread::get_id()));
+        seed = seed * 1103515245u + 12345u;
+        size_t start = (seed >> 16) % _workers.size();
+        for (size_t i = 0; i < _workers.size(); ++i) {
+            Worker* victim = _workers[(start + i) % _workers.size()].get();
+            if (victim != self && victim->tasks.try_steal_front(task))
+                return true;
+        }
+        return false;
+    }
+
+    static void execute(Task* task) {
+        std::atomic<size_t>* pending = task->pending;
+        task->work();
+        delete task;
+        pending->fetch_sub(1, std::memory_order_release);
+    }
+
+    // Runs one task from anywhere in the pool; self is null for threads outside the pool
+    inline bool run_one(Worker* self) {
+        Task* task = nullptr;
+        if ((self != nullptr && self->tasks.try_pop_back(task)) || pop_injected(task) || steal(self, task)) {
+            execute(task);
+            return true;
+        }
+        return false;
+    }
+
+    void work(Worker* self) {
+        current_worker() = self;
+        for (;;) {
+            if (run_one(self))
+                continue;
+            if (_stopping.load(std::memory_order_acquire))
+                return;
+            if (_active_runs.load(std::memory_order_acquire) == 0) {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _wake.wait(lock, [this]() {
+                    return _stopping.load(std::memory_order_relaxed) || _active_runs.load(std::memory_order_relaxed) > 0;
+                });
+                continue;
+            }
+            std::this_thread::yield();
+        }
+    }
+
+public:
+
+    // Tasks spawned together that are waited for together
+    class TaskGroup {
+
+    private:
+
+        ForkJoinPool& _pool;
+        std::atomic<size_t> _pending;
+
+    public:
+
+        explicit TaskGroup(ForkJoinPool& pool) : _pool(pool), _pending(0) {}
+
+        TaskGroup(const TaskGroup&) = delete;
+
+        TaskGroup& operator =(const TaskGroup&) = delete;
+
+        ~TaskGroup() {
+            wait();
+        }
+
+        template <class F>
+        void spawn(F&& f) {
+            _pending.fetch_add(1, std::memory_order_relaxed);
+            _pool.submit(new Task{std::function<void()>(std::forward<F>(f)), &_pending});
+        }
+
+        // Runs tasks of the pool until all tasks of the group have finished
+        void wait() {
+            Worker* self = _pool.current();
+            while (_pending.load(std::memory_order_acquire) != 0) {
+                if (!_pool.run_one(self))
+                    std::this_thread::yield();
+            }
+        }
+    };
+
+    // Constructors & destructors
+
+    explicit ForkJoinPool(size_t threads = std::thread::hardware_concurrency(),
+                          ForkJoinScheduling scheduling = FORK_JOIN_WORK_STEALING)
+            : _scheduling(scheduling), _injected_size(0), _active_runs(0), _stopping(false) {
+        if (threads == 0)
+            threads = 1;
+        for (size_t i = 0; i < threads; ++i)
+            _workers.push_back(std::unique_ptr<Worker>(new Worker(this)));
+        for (size_t i = 0; i < threads; ++i)
+            _workers[i]->thread = std::thread(&ForkJoinPool::work, this, _workers[i].get());
+    }
+
+    ForkJoinPool(const ForkJoinPool&) = delete;
+
+    ForkJoinPool& operator =(const ForkJoinPool&) = delete;
+
+    // No run() may be in progress
+    ~ForkJoinPool() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping.store(true, std::memory_order_release);
+        }
+        _wake.notify_all();
+        for (size_t i = 0; i < _workers.size(); ++i)
+            _workers[i]->thread.join();
+    }
+
+    size_t size() const {
+        return _workers.size();
+    }
+
+    // Runs f in the pool and waits for it; the calling thread helps with the work meanwhile
+    template <class F>
+    void run(F&& f) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _active_runs.fetch_add(1, std::memory_order_release);
+        }
+        _wake.notify_all();
+        {
+            TaskGroup group(*this);
+            group.spawn(std::forward<F>(f));
+        }
+        _active_runs.fetch_sub(1, std::memory_order_release);
+    }
+};
+
+#endif //DEQUE_FORK_JOIN_POOL_H
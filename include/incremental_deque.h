@@ -0,0 +1,368 @@
+//
+// Created by anton on 17.10.26.
+//
+
+#ifndef DEQUE_INCREMENTAL_DEQUE_H
+#define DEQUE_INCREMENTAL_DEQUE_H
+
+#include <stdexcept>
+#include <string>
+#include <new>
+#include <utility>
+
+#include "deque_iterator.h"
+#include "deque_policy.h"
+
+// Deque with worst-case O(1) push and pop.
+//
+// Instead of copying the whole ring on a resize, IncrementalDeque keeps the old buffer alive
+// next to the new one and migrates MIGRATION_STEP elements on every push and pop. The elements
+// that are not migrated yet form one contiguous window of logical indices, which stays in the
+// old buffer until migration reaches it. With MIGRATION_STEP = 2 and a policy that keeps
+// HYSTERESIS >= 2, the migration always finishes before the next resize is due.
+template <class T, class Policy = DequeGrowthPolicy>
+class IncrementalDeque {
+
+private:
+
+    T* _buffer = nullptr;
+
+    size_t _head;
+    size_t _capacity;
+    size_t _size;
+
+    // Not yet migrated window: _old_count elements starting at logical index _old_offset,
+    // stored in _old_buffer starting at _old_first
+    T* _old_buffer = nullptr;
+
+    size_t _old_capacity = 0;
+    size_t _old_first = 0;
+    size_t _old_offset = 0;
+    size_t _old_count = 0;
+
+    static const size_t MIGRATION_STEP = 2;
+
+    static_assert(Policy::MIN_CAPACITY >= 2 && (Policy::MIN_CAPACITY & (Policy::MIN_CAPACITY - 1)) == 0,
+                  "IncrementalDeque policy: MIN_CAPACITY must be a power of two");
+    static_assert(Policy::GROWTH_SHIFT > 0 && Policy::SHRINK_SHIFT > 0,
+                  "IncrementalDeque policy: capacity must change on every resize");
+    static_assert(Policy::HYSTERESIS >= 2 &&
+                  Policy::SHRINK_THRESHOLD >= (Policy::HYSTERESIS << Policy::GROWTH_SHIFT) &&
+                  Policy::SHRINK_THRESHOLD >= (Policy::HYSTERESIS << Policy::SHRINK_SHIFT),
+                  "IncrementalDeque policy: migration needs a hysteresis band of at least 2");
+
+    static T* allocate(size_t capacity) {
+        return static_cast<T*>(::operator new(capacity * sizeof(T)));
+    }
+
+    static void deallocate(T* buffer) {
+        ::operator delete(buffer);
+    }
+
+    template <class... Args>
+    static void construct(T* place, Args&&... args) {
+        ::new (static_cast<void*>(place)) T(std::forward<Args>(args)...);
+    }
+
+    inline size_t wrap(size_t pos) const {
+        return pos & (_capacity - 1);
+    }
+
+    inline size_t wrap_old(size_t pos) const {
+        return pos & (_old_capacity - 1);
+    }
+
+    inline bool is_migrating() const {
+        return _old_buffer != nullptr;
+    }
+
+    inline bool in_old_window(size_t pos) const {
+        return pos - _old_offset < _old_count;
+    }
+
+    inline T* slot(size_t pos) const {
+        if (is_migrating() && in_old_window(pos))
+            return _old_buffer + wrap_old(_old_first + (pos - _old_offset));
+        return _buffer + wrap(_head + pos);
+    }
+
+    inline void release_old_buffer() {
+        deallocate(_old_buffer);
+        _old_buffer = nullptr;
+        _old_count = 0;
+    }
+
+    inline void migrate(size_t count) {
+        for (; count > 0 && _old_count > 0; --count) {
+            T* from = _old_buffer + _old_first;
+            construct(_buffer + wrap(_head + _old_offset), std::move_if_noexcept(*from));
+            from->~T();
+            _old_first = wrap_old(_old_first + 1);
+            ++_old_offset;
+            --_old_count;
+        }
+        if (is_migrating() && _old_count == 0)
+            release_old_buffer();
+    }
+
+    // The current buffer becomes the old one, and every element is left in the migration window.
+    // Only the allocation happens here, so the call is O(1) apart from the allocator itself.
+    inline void start_resize(size_t new_capacity) {
+        if (is_migrating())
+            migrate(_old_count);
+        T* new_buffer = allocate(new_capacity);
+
+        _old_buffer = _buffer;
+        _old_capacity = _capacity;
+        _old_first = _head;
+        _old_offset = 0;
+        _old_count = _size;
+        if (_old_count == 0)
+            release_old_buffer();
+
+        _buffer = new_buffer;
+        _capacity = new_capacity;
+        _head = 0;
+    }
+
+    inline void try_to_increase_capacity() {
+        if (_size == _capacity)
+            start_resize(_capacity << Policy::GROWTH_SHIFT);
+    }
+
+    inline void try_to_decrease_capacity() {
+        if (is_migrating() || !(_size < _capacity / Policy::SHRINK_THRESHOLD) || _capacity <= Policy::MIN_CAPACITY)
+            return;
+        size_t new_capacity = _capacity >> Policy::SHRINK_SHIFT;
+        if (new_capacity < Policy::MIN_CAPACITY)
+            new_capacity = Policy::MIN_CAPACITY;
+        start_resize(new_capacity);
+    }
+
+    inline void destroy_elements() {
+        for (size_t i = 0; i < _size; ++i)
+            slot(i)->~T();
+        if (is_migrating())
+            release_old_buffer();
+    }
+
+public:
+
+    // Typedef iterators
+
+    typedef DequeIndexIterator<IncrementalDeque, T> iterator;
+    typedef DequeIndexIterator<const IncrementalDeque, const T> const_iterator;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    // Constructors & destructors
+
+    IncrementalDeque() {
+        _capacity = Policy::MIN_CAPACITY;
+        _buffer = allocate(_capacity);
+        _head = 0;
+        _size = 0;
+    }
+
+    IncrementalDeque(const IncrementalDeque& other) {
+        _capacity = other._capacity;
+        _buffer = allocate(_capacity);
+        _head = 0;
+        _size = 0;
+        try {
+            for (; _size < other.size(); ++_size)
+                construct(_buffer + _size, other[_size]);
+        } catch (...) {
+            destroy_elements();
+            deallocate(_buffer);
+            throw;
+        }
+    }
+
+    ~IncrementalDeque() {
+        destroy_elements();
+        deallocate(_buffer);
+    }
+
+    IncrementalDeque& operator =(const IncrementalDeque& other) {
+        if (this == &other)
+            return *this;
+        IncrementalDeque temp(other);
+        std::swap(_buffer, temp._buffer);
+        std::swap(_head, temp._head);
+        std::swap(_capacity, temp._capacity);
+        std::swap(_size, temp._size);
+        std::swap(_old_buffer, temp._old_buffer);
+        std::swap(_old_capacity, temp._old_capacity);
+        std::swap(_old_first, temp._old_first);
+        std::swap(_old_offset, temp._old_offset);
+        std::swap(_old_count, temp._old_count);
+        return *this;
+    }
+
+    // Element access
+
+    T& at(size_t pos) {
+        if (!(pos < size())) {
+            throw std::out_of_range("IncrementalDeque::out of range, pos(" + std::to_string(pos) + ") >= size (" + std::to_string(size()) + ")");
+        }
+        return (*this)[pos];
+    }
+
+    const T& at(size_t pos) const {
+        if (!(pos < size())) {
+            throw std::out_of_range("IncrementalDeque::out of range, pos(" + std::to_string(pos) + ") >= size (" + std::to_string(size()) + ")");
+        }
+        return (*this)[pos];
+    }
+
+    T& operator [](size_t pos) {
+        return *slot(pos);
+    }
+
+    const T& operator [](size_t pos) const {
+        return *slot(pos);
+    }
+
+    T& front() {
+        return (*this)[0];
+    }
+
+    const T& front() const {
+        return (*this)[0];
+    }
+
+    T& back() {
+        return (*this)[size() - 1];
+    }
+
+    const T& back() const {
+        return (*this)[size() - 1];
+    }
+
+    // Capacity
+
+    bool empty() const {
+        return !size();
+    }
+
+    size_t size() const {
+        return _size;
+    }
+
+    // Modifiers
+
+    void clear() {
+        (*this) = IncrementalDeque();
+    }
+
+    template <class... Args>
+    T& emplace_back(Args&&... args) {
+        try_to_increase_capacity();
+        construct(_buffer + wrap(_head + _size), std::forward<Args>(args)...);
+        ++_size;
+        migrate(MIGRATION_STEP);
+        return back();
+    }
+
+    void push_back(const T& elem) {
+        emplace_back(elem);
+    }
+
+    void push_back(T&& elem) {
+        emplace_back(std::move(elem));
+    }
+
+    void pop_back() {
+        --_size;
+        if (is_migrating() && _old_offset + _old_count == _size + 1) {
+            --_old_count;
+            _old_buffer[wrap_old(_old_first + _old_count)].~T();
+        } else {
+            _buffer[wrap(_head + _size)].~T();
+        }
+        migrate(MIGRATION_STEP);
+        try_to_decrease_capacity();
+    }
+
+    template <class... Args>
+    T& emplace_front(Args&&... args) {
+        try_to_increase_capacity();
+        size_t new_head = wrap(_head - 1);
+        construct(_buffer + new_head, std::forward<Args>(args)...);
+        _head = new_head;
+        ++_size;
+        if (is_migrating())
+            ++_old_offset;
+        migrate(MIGRATION_STEP);
+        return front();
+    }
+
+    void push_front(const T& elem) {
+        emplace_front(elem);
+    }
+
+    void push_front(T&& elem) {
+        emplace_front(std::move(elem));
+    }
+
+    void pop_front() {
+        if (is_migrating() && _old_offset == 0) {
+            _old_buffer[_old_first].~T();
+            _old_first = wrap_old(_old_first + 1);
+            --_old_count;
+        } else {
+            _buffer[_head].~T();
+            if (is_migrating())
+                --_old_offset;
+        }
+        _head = wrap(_head + 1);
+        --_size;
+        migrate(MIGRATION_STEP);
+        try_to_decrease_capacity();
+    }
+
+    // Iterators
+
+    iterator begin() {
+        return iterator(this, 0);
+    }
+
+    const_iterator begin() const {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator cbegin() const {
+        return const_iterator(this, 0);
+    }
+
+    iterator end() {
+        return iterator(this, size());
+    }
+
+    const_iterator end() const {
+        return const_iterator(this, size());
+    }
+
+    const_iterator cend() const {
+        return const_iterator(this, size());
+    }
+
+    reverse_iterator rbegin() {
+        return reverse_iterator(end());
+    }
+
+    const_reverse_iterator rbegin() const {
+        return const_reverse_iterator(cend());
+    }
+
+    reverse_iterator rend() {
+        return reverse_iterator(begin());
+    }
+
+    const_reverse_iterator rend() const {
+        return const_reverse_iterator(cbegin());
+    }
+};
+
+#endif //DEQUE_INCREMENTAL_DEQUE_H
@@ -0,0 +1,391 @@
+//
+// Created by anton on 17.10.26.
+//
+
+#ifndef DEQUE_MIRRORED_DEQUE_H
+#define DEQUE_MIRRORED_DEQUE_H
+
+#if defined(__linux__)
+#define DEQUE_HAS_MIRRORED_DEQUE
+
+#include <stdexcept>
+#include <string>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iterator>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "deque_segment.h"
+
+// Deque whose ring is mapped twice, back to back, in virtual memory (Linux only).
+//
+// The same memfd pages back [_buffer, _buffer + capacity) and [_buffer + capacity, _buffer + 2 * capacity),
+// so the elements are always one contiguous array starting at _buffer + _head. Indexing needs no
+// wrapping, iterators are plain pointers, and any range can be handed to read/write or SIMD code
+// as a single pointer. Only the head wraps, with a compare instead of a mask.
+//
+// The buffer size is a multiple of both the page size and sizeof(T), so the capacity is generally
+// not a power of two. The ring doubles when full and never shrinks, except via shrink_to_fit().
+template <class T>
+class MirroredDeque {
+
+private:
+
+    static_assert(std::is_trivially_copyable<T>::value, "MirroredDeque: T must be trivially copyable");
+
+    T* _buffer = nullptr;
+
+    size_t _head = 0;
+    size_t _size = 0;
+    size_t _capacity = 0;
+
+    static size_t gcd(size_t a, size_t b) {
+        while (b != 0) {
+            size_t r = a % b;
+            a = b;
+            b = r;
+        }
+        return a;
+    }
+
+    // Smallest capacity that is at least min_capacity and fills whole pages
+    static size_t fit_capacity(size_t min_capacity) {
+        size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        size_t unit = page / gcd(page, sizeof(T));
+        size_t units = (std::max(min_capacity, size_t(1)) + unit - 1) / unit;
+        return units * unit;
+    }
+
+    static void fail(const char* call) {
+        throw std::system_error(errno, std::generic_category(), std::string("MirroredDeque::") + call);
+    }
+
+    // Maps a memfd of capacity elements twice: the address range is reserved first,
+    // then both halves are mapped over it with MAP_FIXED
+    static T* map_mirror(size_t capacity) {
+        size_t bytes = capacity * sizeof(T);
+        int fd = memfd_create("MirroredDeque", MFD_CLOEXEC);
+        if (fd == -1)
+            fail("memfd_create");
+        if (ftruncate(fd, static_cast<off_t>(bytes)) == -1) {
+            int error = errno;
+            close(fd);
+            errno = error;
+            fail("ftruncate");
+        }
+        void* area = mmap(nullptr, 2 * bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (area == MAP_FAILED) {
+            int error = errno;
+            close(fd);
+            errno = error;
+            fail("mmap");
+        }
+        char* base = static_cast<char*>(area);
+        if (mmap(base, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED ||
+            mmap(base + bytes, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+            int error = errno;
+            munmap(area, 2 * bytes);
+            close(fd);
+            errno = error;
+            fail("mmap");
+        }
+        // The mappings keep the memory alive
+        close(fd);
+        return reinterpret_cast<T*>(base);
+    }
+
+    static void unmap_mirror(T* buffer, size_t capacity) {
+        if (buffer != nullptr)
+            munmap(buffer, 2 * capacity * sizeof(T));
+    }
+
+    inline void realloc(size_t new_capacity) {
+        T* new_buffer = map_mirror(new_capacity);
+        if (_size > 0)
+            std::memcpy(static_cast<void*>(new_buffer), _buffer + _head, _size * sizeof(T));
+        unmap_mirror(_buffer, _capacity);
+        _buffer = new_buffer;
+        _capacity = new_capacity;
+        _head = 0;
+    }
+
+    inline void grow_for(size_t count) {
+        if (_size + count > _capacity)
+            realloc(fit_capacity(std::max(_size + count, 2 * _capacity)));
+    }
+
+    inline void advance_head(size_t count) {
+        _head += count;
+        if (_head >= _capacity)
+            _head -= _capacity;
+    }
+
+public:
+
+    typedef T* iterator;
+    typedef const T* const_iterator;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    // Constructors & destructors
+
+    MirroredDeque() {
+        realloc(fit_capacity(1));
+    }
+
+    MirroredDeque(const MirroredDeque& other) {
+        realloc(fit_capacity(other.size()));
+        if (!other.empty())
+            std::memcpy(static_cast<void*>(_buffer), other.data(), other.size() * sizeof(T));
+        _size = other.size();
+    }
+
+    // other is left empty, without a buffer; it allocates again on the next push
+    MirroredDeque(MirroredDeque&& other) noexcept {
+        std::swap(_buffer, other._buffer);
+        std::swap(_head, other._head);
+        std::swap(_size, other._size);
+        std::swap(_capacity, other._capacity);
+    }
+
+    ~MirroredDeque() {
+        unmap_mirror(_buffer, _capacity);
+    }
+
+    MirroredDeque& operator =(const MirroredDeque& other) {
+        if (this == &other)
+            return *this;
+        MirroredDeque temp(other);
+        return *this = std::move(temp);
+    }
+
+    MirroredDeque& operator =(MirroredDeque&& other) noexcept {
+        std::swap(_buffer, other._buffer);
+        std::swap(_head, other._head);
+        std::swap(_size, other._size);
+        std::swap(_capacity, other._capacity);
+        return *this;
+    }
+
+    // Element access
+
+    T& at(size_t pos) {
+        if (!(pos < size())) {
+            throw std::out_of_range("MirroredDeque::out of range, pos(" + std::to_string(pos) + ") >= size (" + std::to_string(size()) + ")");
+        }
+        return (*this)[pos];
+    }
+
+    const T& at(size_t pos) const {
+        if (!(pos < size())) {
+            throw std::out_of_range("MirroredDeque::out of range, pos(" + std::to_string(pos) + ") >= size (" + std::to_string(size()) + ")");
+        }
+        return (*this)[pos];
+    }
+
+    T& operator [](size_t pos) {
+        return _buffer[_head + pos];
+    }
+
+    const T& operator [](size_t pos) const {
+        return _buffer[_head + pos];
+    }
+
+    T& front() {
+        return (*this)[0];
+    }
+
+    const T& front() const {
+        return (*this)[0];
+    }
+
+    T& back() {
+        return (*this)[size() - 1];
+    }
+
+    const T& back() const {
+        return (*this)[size() - 1];
+    }
+
+    // Contiguous storage
+
+    // The elements are always one array of size() elements
+    T* data() {
+        return _buffer + _head;
+    }
+
+    const T* data() const {
+        return _buffer + _head;
+    }
+
+    DequeSegments<T*> segments() {
+        DequeSegments<T*> result = {{data(), size()}, {_buffer, 0}};
+        return result;
+    }
+
+    DequeSegments<const T*> segments() const {
+        DequeSegments<const T*> result = {{data(), size()}, {_buffer, 0}};
+        return result;
+    }
+
+    // Returns count contiguous free slots after the last element, e.g. as the target of read().
+    // They become elements only after commit_back(); until then any push may reuse them.
+    T* prepare_back(size_t count) {
+        grow_for(count);
+        return _buffer + _head + _size;
+    }
+
+    void commit_back(size_t count) {
+        _size += count;
+    }
+
+    // Capacity
+
+    bool empty() const {
+        return !size();
+    }
+
+    size_t size() const {
+        return _size;
+    }
+
+    size_t capacity() const {
+        return _capacity;
+    }
+
+    void reserve(size_t new_capacity) {
+        if (new_capacity > _capacity)
+            realloc(fit_capacity(new_capacity));
+    }
+
+    void shrink_to_fit() {
+        size_t fitted_capacity = fit_capacity(size());
+        if (fitted_capacity < _capacity)
+            realloc(fitted_capacity);
+    }
+
+    // Modifiers
+
+    void clear() {
+        _head = 0;
+        _size = 0;
+    }
+
+    // A reallocation unmaps the old buffer, so a full deque builds the new element first:
+    // args may refer to one of its elements
+    template <class... Args>
+    T& emplace_back(Args&&... args) {
+        T elem(std::forward<Args>(args)...);
+        grow_for(1);
+        _buffer[_head + _size] = elem;
+        ++_size;
+        return back();
+    }
+
+    void push_back(const T& elem) {
+        emplace_back(elem);
+    }
+
+    void pop_back() {
+        --_size;
+    }
+
+    template <class... Args>
+    T& emplace_front(Args&&... args) {
+        T elem(std::forward<Args>(args)...);
+        grow_for(1);
+        _head = _head == 0 ? _capacity - 1 : _head - 1;
+        _buffer[_head] = elem;
+        ++_size;
+        return front();
+    }
+
+    void push_front(const T& elem) {
+        emplace_front(elem);
+    }
+
+    void pop_front() {
+        advance_head(1);
+        --_size;
+    }
+
+    // Bulk operations copy one contiguous range
+
+    void append(const T* first, const T* last) {
+        size_t count = last - first;
+        if (count == 0)
+            return;
+        if (first >= _buffer && first < _buffer + 2 * _capacity) {
+            // The source is inside this deque and would be unmapped by a reallocation
+            MirroredDeque temp;
+            temp.append(first, last);
+            append(temp.data(), temp.data() + count);
+            return;
+        }
+        std::memcpy(static_cast<void*>(prepare_back(count)), first, count * sizeof(T));
+        commit_back(count);
+    }
+
+    // Copies min(count, size()) elements from the front to out and pops them
+    T* pop_front_n(size_t count, T* out) {
+        count = std::min(count, size());
+        if (count == 0)
+            return out;
+        std::memcpy(static_cast<void*>(out), data(), count * sizeof(T));
+        advance_head(count);
+        _size -= count;
+        return out + count;
+    }
+
+    // Iterators
+
+    iterator begin() {
+        return data();
+    }
+
+    const_iterator begin() const {
+        return data();
+    }
+
+    const_iterator cbegin() const {
+        return data();
+    }
+
+    iterator end() {
+        return data() + size();
+    }
+
+    const_iterator end() const {
+        return data() + size();
+    }
+
+    const_iterator cend() const {
+        return data() + size();
+    }
+
+    reverse_iterator rbegin() {
+        return reverse_iterator(end());
+    }
+
+    const_reverse_iterator rbegin() const {
+        return const_reverse_iterator(cend());
+    }
+
+    reverse_iterator rend() {
+        return reverse_iterator(begin());
+    }
+
+    const_reverse_iterator rend() const {
+        return const_reverse_iterator(cbegin());
+    }
+};
+
+#endif
+
+#endif //DEQUE_MIRRORED_DEQUE_H
@@ -0,0 +1,223 @@
+//
+// Created by anton on 17.10.26.
+//
+
+#ifndef DEQUE_MPMC_DEQUE_H
+#define DEQUE_MPMC_DEQUE_H
+
+#include <stdexcept>
+#include <atomic>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "deque_policy.h"
+
+// Lock-free bounded queue for any number of producer and consumer threads,
+// with a sequence number per slot (D. Vyukov's bounded MPMC queue).
+//
+// The ring is the power-of-two buffer of Deque; producers claim positions by advancing _tail and
+// consumers by advancing _head, both with compare-and-swap. The sequence number of a slot says
+// whose turn it is: pos while the slot is free for the producer of position pos, pos + 1 once the
+// element is published for the consumer of pos, and pos + capacity() after the consumer has freed it
+// for the next lap. Each slot is published with a release store and checked with an acquire load.
+//
+// The bulk operations claim a run of consecutive ready slots with one compare-and-swap.
+// A claimed slot must be published, so elements whose constructor may throw are built before the claim
+// and moved into the slot, and bulk pushes of them fall back to single pushes.
+template <class T>
+class MpmcDeque {
+
+private:
+
+    static_assert(std::is_nothrow_move_constructible<T>::value, "MpmcDeque: T must be nothrow move constructible");
+
+    struct Cell {
+        std::atomic<size_t> sequence;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+        T* element() {
+            return reinterpret_cast<T*>(&storage);
+        }
+    };
+
+    // Written only in the constructor
+    Cell* _cells;
+    size_t _capacity;
+
+    alignas(DEQUE_CACHE_LINE_SIZE) std::atomic<size_t> _head;
+
+    alignas(DEQUE_CACHE_LINE_SIZE) std::atomic<size_t> _tail;
+
+    inline Cell& cell(size_t pos) const {
+        return _cells[pos & (_capacity - 1)];
+    }
+
+    // Claims up to count consecutive positions starting at index whose cells have sequence
+    // pos + offset. Returns the first claimed position and stores the number of them in count.
+    inline size_t claim(std::atomic<size_t>& index, size_t offset, size_t& count) {
+        size_t pos = index.load(std::memory_order_relaxed);
+        if (count == 0)
+            return pos;
+        for (;;) {
+            size_t ready = 0;
+            while (ready < count) {
+                size_t sequence = cell(pos + ready).sequence.load(std::memory_order_acquire);
+                if (sequence != pos + ready + offset)
+                    break;
+                ++ready;
+            }
+            if (ready == 0) {
+                // Either the ring is full (empty), or another thread has claimed pos already
+                size_t sequence = cell(pos).sequence.load(std::memory_order_acquire);
+                if (static_cast<std::ptrdiff_t>(sequence - (pos + offset)) < 0) {
+                    count = 0;
+                    return pos;
+                }
+                pos = index.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (index.compare_exchange_weak(pos, pos + ready, std::memory_order_relaxed)) {
+                count = ready;
+                return pos;
+            }
+        }
+    }
+
+    template <class... Args>
+    inline void publish(size_t pos, Args&&... args) {
+        Cell& target = cell(pos);
+        ::new (static_cast<void*>(&target.storage)) T(std::forward<Args>(args)...);
+        target.sequence.store(pos + 1, std::memory_order_release);
+    }
+
+    template <class OutputIt>
+    inline void consume(size_t pos, OutputIt& out) {
+        Cell& source = cell(pos);
+        *out = std::move(*source.element());
+        ++out;
+        source.element()->~T();
+        source.sequence.store(pos + _capacity, std::memory_order_release);
+    }
+
+    template <class... Args>
+    inline bool emplace_with(std::true_type, Args&&... args) {
+        size_t count = 1;
+        size_t pos = claim(_tail, 0, count);
+        if (count == 0)
+            return false;
+        publish(pos, std::forward<Args>(args)...);
+        return true;
+    }
+
+    // A claimed slot must be published, so a constructor that may throw runs before the claim
+    template <class... Args>
+    inline bool emplace_with(std::false_type, Args&&... args) {
+        T elem(std::forward<Args>(args)...);
+        return emplace_with(std::true_type(), std::move(elem));
+    }
+
+    template <class InputIt>
+    inline size_t push_n_with(std::true_type, InputIt first, size_t count) {
+        size_t pos = claim(_tail, 0, count);
+        for (size_t i = 0; i < count; ++i, ++first)
+            publish(pos + i, *first);
+        return count;
+    }
+
+    template <class InputIt>
+    inline size_t push_n_with(std::false_type, InputIt first, size_t count) {
+        size_t pushed = 0;
+        for (; pushed < count && try_push(*first); ++pushed, ++first) {}
+        return pushed;
+    }
+
+public:
+
+    // Constructors & destructors
+
+    // The capacity is rounded up to a power of two, at least 2
+    explicit MpmcDeque(size_t capacity) : _head(0), _tail(0) {
+        if (capacity == 0)
+            throw std::invalid_argument("MpmcDeque::capacity must be positive");
+        _capacity = 2;
+        while (_capacity < capacity)
+            _capacity <<= 1;
+        _cells = static_cast<Cell*>(::operator new(_capacity * sizeof(Cell)));
+        for (size_t i = 0; i < _capacity; ++i)
+            ::new (static_cast<void*>(&_cells[i].sequence)) std::atomic<size_t>(i);
+    }
+
+    MpmcDeque(const MpmcDeque&) = delete;
+
+    MpmcDeque& operator =(const MpmcDeque&) = delete;
+
+    // No thread may use the deque any more
+    ~MpmcDeque() {
+        size_t tail = _tail.load(std::memory_order_acquire);
+        for (size_t pos = _head.load(std::memory_order_acquire); pos != tail; ++pos)
+            cell(pos).element()->~T();
+        ::operator delete(_cells);
+    }
+
+    // Capacity
+
+    size_t capacity() const {
+        return _capacity;
+    }
+
+    // May be outdated by the time it returns
+    size_t size_approx() const {
+        size_t head = _head.load(std::memory_order_acquire);
+        size_t tail = _tail.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+
+    // Producers
+
+    template <class... Args>
+    bool try_emplace(Args&&... args) {
+        return emplace_with(std::integral_constant<bool, std::is_nothrow_constructible<T, Args&&...>::value>(),
+                            std::forward<Args>(args)...);
+    }
+
+    bool try_push(const T& elem) {
+        return try_emplace(elem);
+    }
+
+    bool try_push(T&& elem) {
+        return try_emplace(std::move(elem));
+    }
+
+    // Pushes the first elements of [first, first + count), as many as there are free
+    // consecutive slots, and returns their number
+    template <class InputIt>
+    size_t try_push_n(InputIt first, size_t count) {
+        return push_n_with(std::integral_constant<bool,
+                std::is_nothrow_constructible<T, decltype(*first)>::value>(), first, count);
+    }
+
+    // Consumers
+
+    bool try_pop(T& out) {
+        size_t count = 1;
+        size_t pos = claim(_head, 1, count);
+        if (count == 0)
+            return false;
+        T* target = &out;
+        consume(pos, target);
+        return true;
+    }
+
+    // Moves up to count elements to out, as many as are published in consecutive slots,
+    // and returns their number. Writing to out must not throw.
+    template <class OutputIt>
+    size_t try_pop_n(OutputIt out, size_t count) {
+        size_t pos = claim(_head, 1, count);
+        for (size_t i = 0; i < count; ++i)
+            consume(pos + i, out);
+        return count;
+    }
+};
+
+#endif //DEQUE_MPMC_DEQUE_H
@@ -0,0 +1,397 @@
+//
+// Created by anton on 17.10.26.
+//
+
+#ifndef DEQUE_SEGMENTED_DEQUE_H
+#define DEQUE_SEGMENTED_DEQUE_H
+
+#include <stdexcept>
+#include <string>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <utility>
+
+#include "deque_iterator.h"
+
+// Largest power of two not greater than max_elements, at least one
+constexpr size_t segmented_deque_block_size(size_t max_elements, size_t result = 1) {
+    return result * 2 > max_elements ? result : segmented_deque_block_size(max_elements, result * 2);
+}
+
+// Deque made of fixed-size blocks, with a small ring of block pointers (the map).
+//
+// Elements never move once constructed: pushes at either end add a block when the outer one
+// is full, pops release a block once it is empty, and growing reallocates only the map.
+// References and pointers to elements stay valid until the element itself is popped.
+// Iterators are invalidated by any push or pop, as for Deque.
+//
+// A block holds the largest power of two of elements that fits into BlockBytes, at least one.
+// One released block is kept as a spare, so pushing and popping across a block boundary
+// does not allocate every time.
+template <class T, size_t BlockBytes = 4096>
+class SegmentedDeque {
+
+private:
+
+    static const size_t BLOCK_SIZE = segmented_deque_block_size(BlockBytes / sizeof(T));
+    static const size_t MIN_MAP_CAPACITY = 4;
+
+    // Ring of _map_capacity block pointers, the blocks in use are _block_count of them from _first_block
+    T** _map = nullptr;
+    size_t _map_capacity = 0;
+    size_t _first_block = 0;
+    size_t _block_count = 0;
+
+    T* _spare_block = nullptr;
+
+    // The elements occupy positions [_start, _start + _size) counted from the start of the first block
+    size_t _start = 0;
+    size_t _size = 0;
+
+    static T* allocate_block() {
+        return static_cast<T*>(::operator new(BLOCK_SIZE * sizeof(T)));
+    }
+
+    template <class... Args>
+    static void construct(T* place, Args&&... args) {
+        ::new (static_cast<void*>(place)) T(std::forward<Args>(args)...);
+    }
+
+    inline size_t wrap_map(size_t pos) const {
+        return pos & (_map_capacity - 1);
+    }
+
+    inline T*& block(size_t index) const {
+        return _map[wrap_map(_first_block + index)];
+    }
+
+    inline T* slot_at(size_t position) const {
+        return block(position / BLOCK_SIZE) + position % BLOCK_SIZE;
+    }
+
+    inline T* take_block() {
+        if (_spare_block == nullptr)
+            return allocate_block();
+        T* result = _spare_block;
+        _spare_block = nullptr;
+        return result;
+    }
+
+    inline void release_block(T* released) {
+        if (_spare_block == nullptr)
+            _spare_block = released;
+        else
+            ::operator delete(released);
+    }
+
+    // Only the block pointers are copied, the blocks stay where they are
+    inline void grow_map() {
+        size_t new_capacity = _map_capacity == 0 ? MIN_MAP_CAPACITY : _map_capacity * 2;
+        T** new_map = new T*[new_capacity];
+        for (size_t i = 0; i < _block_count; ++i)
+            new_map[i] = block(i);
+        delete[] _map;
+        _map = new_map;
+        _map_capacity = new_capacity;
+        _first_block = 0;
+    }
+
+    inline void add_block_back() {
+        if (_block_count == _map_capacity)
+            grow_map();
+        T* added = take_block();
+        block(_block_count) = added;
+        ++_block_count;
+    }
+
+    inline void add_block_front() {
+        if (_block_count == _map_capacity)
+            grow_map();
+        T* added = take_block();
+        _first_block = wrap_map(_first_block - 1);
+        block(0) = added;
+        ++_block_count;
+        _start += BLOCK_SIZE;
+    }
+
+    inline void remove_block_back() {
+        --_block_count;
+        release_block(block(_block_count));
+    }
+
+    inline void remove_block_front() {
+        release_block(block(0));
+        _first_block = wrap_map(_first_block + 1);
+        --_block_count;
+        _start -= BLOCK_SIZE;
+    }
+
+    inline void destroy_elements() {
+        for (size_t i = 0; i < size(); ++i)
+            (*this)[i].~T();
+    }
+
+    inline void release_storage() {
+        for (size_t i = 0; i < _block_count; ++i)
+            ::operator delete(block(i));
+        ::operator delete(_spare_block);
+        delete[] _map;
+    }
+
+    inline void steal_storage(SegmentedDeque& other) {
+        _map = other._map;
+        _map_capacity = other._map_capacity;
+        _first_block = other._first_block;
+        _block_count = other._block_count;
+        _spare_block = other._spare_block;
+        _start = other._start;
+        _size = other._size;
+        other._map = nullptr;
+        other._map_capacity = 0;
+        other._first_block = 0;
+        other._block_count = 0;
+        other._spare_block = nullptr;
+        other._start = 0;
+        other._size = 0;
+    }
+
+public:
+
+    // Typedef iterators
+
+    typedef DequeIndexIterator<SegmentedDeque, T> iterator;
+    typedef DequeIndexIterator<const SegmentedDeque, const T> const_iterator;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    // Constructors & destructors
+
+    SegmentedDeque() {}
+
+    SegmentedDeque(std::initializer_list<T> elems) {
+        try {
+            for (const T& elem : elems)
+                push_back(elem);
+        } catch (...) {
+            destroy_elements();
+            release_storage();
+            throw;
+        }
+    }
+
+    SegmentedDeque(const SegmentedDeque& other) {
+        try {
+            for (size_t i = 0; i < other.size(); ++i)
+                push_back(other[i]);
+        } catch (...) {
+            destroy_elements();
+            release_storage();
+            throw;
+        }
+    }
+
+    SegmentedDeque(SegmentedDeque&& other) noexcept {
+        steal_storage(other);
+    }
+
+    ~SegmentedDeque() {
+        destroy_elements();
+        release_storage();
+    }
+
+    SegmentedDeque& operator =(const SegmentedDeque& other) {
+        if (this == &other)
+            return *this;
+        SegmentedDeque temp(other);
+        return *this = std::move(temp);
+    }
+
+    SegmentedDeque& operator =(SegmentedDeque&& other) noexcept {
+        if (this == &other)
+            return *this;
+        destroy_elements();
+        release_storage();
+        steal_storage(other);
+        return *this;
+    }
+
+    // Element access
+
+    T& at(size_t pos) {
+        if (!(pos < size())) {
+            throw std::out_of_range("SegmentedDeque::out of range, pos(" + std::to_string(pos) + ") >= size (" + std::to_string(size()) + ")");
+        }
+        return (*this)[pos];
+    }
+
+    const T& at(size_t pos) const {
+        if (!(pos < size())) {
+            throw std::out_of_range("SegmentedDeque::out of range, pos(" + std::to_string(pos) + ") >= size (" + std::to_string(size()) + ")");
+        }
+        return (*this)[pos];
+    }
+
+    T& operator [](size_t pos) {
+        return *slot_at(_start + pos);
+    }
+
+    const T& operator [](size_t pos) const {
+        return *slot_at(_start + pos);
+    }
+
+    T& front() {
+        return (*this)[0];
+    }
+
+    const T& front() const {
+        return (*this)[0];
+    }
+
+    T& back() {
+        return (*this)[size() - 1];
+    }
+
+    const T& back() const {
+        return (*this)[size() - 1];
+    }
+
+    // Capacity
+
+    bool empty() const {
+        return !size();
+    }
+
+    size_t size() const {
+        return _size;
+    }
+
+    // Number of elements in one block
+    static size_t block_size() {
+        return BLOCK_SIZE;
+    }
+
+    // Releases the spare block
+    void shrink_to_fit() {
+        ::operator delete(_spare_block);
+        _spare_block = nullptr;
+    }
+
+    // Modifiers
+
+    void clear() {
+        destroy_elements();
+        while (_block_count > 0)
+            remove_block_back();
+        _start = 0;
+        _size = 0;
+    }
+
+    template <class... Args>
+    T& emplace_back(Args&&... args) {
+        bool added = _start + _size == _block_count * BLOCK_SIZE;
+        if (added)
+            add_block_back();
+        try {
+            construct(slot_at(_start + _size), std::forward<Args>(args)...);
+        } catch (...) {
+            if (added)
+                remove_block_back();
+            throw;
+        }
+        ++_size;
+        return back();
+    }
+
+    void push_back(const T& elem) {
+        emplace_back(elem);
+    }
+
+    void push_back(T&& elem) {
+        emplace_back(std::move(elem));
+    }
+
+    void pop_back() {
+        --_size;
+        slot_at(_start + _size)->~T();
+        if (_start + _size <= (_block_count - 1) * BLOCK_SIZE)
+            remove_block_back();
+    }
+
+    template <class... Args>
+    T& emplace_front(Args&&... args) {
+        bool added = _start == 0;
+        if (added)
+            add_block_front();
+        try {
+            construct(slot_at(_start - 1), std::forward<Args>(args)...);
+        } catch (...) {
+            if (added)
+                remove_block_front();
+            throw;
+        }
+        --_start;
+        ++_size;
+        return front();
+    }
+
+    void push_front(const T& elem) {
+        emplace_front(elem);
+    }
+
+    void push_front(T&& elem) {
+        emplace_front(std::move(elem));
+    }
+
+    void pop_front() {
+        slot_at(_start)->~T();
+        ++_start;
+        --_size;
+        if (_start == BLOCK_SIZE)
+            remove_block_front();
+    }
+
+    // Iterators
+
+    iterator begin() {
+        return iterator(this, 0);
+    }
+
+    const_iterator begin() const {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator cbegin() const {
+        return const_iterator(this, 0);
+    }
+
+    iterator end() {
+        return iterator(this, size());
+    }
+
+    const_iterator end() const {
+        return const_iterator(this, size());
+    }
+
+    const_iterator cend() const {
+        return const_iterator(this, size());
+    }
+
+    reverse_iterator rbegin() {
+        return reverse_iterator(end());
+    }
+
+    const_reverse_iterator rbegin() const {
+        return const_reverse_iterator(cend());
+    }
+
+    reverse_iterator rend() {
+        return reverse_iterator(begin());
+    }
+
+    const_reverse_iterator rend() const {
+        return const_reverse_iterator(cbegin());
+    }
+};
+
+#endif //DEQUE_SEGMENTED_DEQUE_H
@@ -0,0 +1,443 @@
+//
+// Created by anton on 17.10.26.
+//
+
+#ifndef DEQUE_SMALL_DEQUE_H
+#define DEQUE_SMALL_DEQUE_H
+
+#include <stdexcept>
+#include <string>
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "deque_iterator.h"
+#include "deque_policy.h"
+#include "deque_segment.h"
+
+// Deque that keeps up to InlineN elements inside the object and moves to a heap ring only
+// when it outgrows them. It shrinks back into the inline buffer once the elements fit there again.
+//
+// InlineN must be a power of two and takes the role of Policy::MIN_CAPACITY; the other policy
+// constants work as in Deque. Unlike Deque, a ring of capacity N holds N elements.
+template <class T, size_t InlineN = 8, class Policy = DequeGrowthPolicy>
+class SmallDeque {
+
+private:
+
+    static_assert(InlineN > 0 && (InlineN & (InlineN - 1)) == 0, "SmallDeque: InlineN must be a power of two");
+    static_assert(Policy::GROWTH_SHIFT > 0 && Policy::SHRINK_SHIFT > 0,
+                  "SmallDeque policy: capacity must change on every resize");
+
+    typedef std::integral_constant<bool, std::is_trivially_copyable<T>::value> trivially_copyable;
+
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type _inline[InlineN];
+
+    T* _buffer;
+
+    size_t _head;
+    size_t _capacity;
+    size_t _size;
+
+    static T* allocate(size_t capacity) {
+        return static_cast<T*>(::operator new(capacity * sizeof(T)));
+    }
+
+    static void deallocate(T* buffer) {
+        ::operator delete(buffer);
+    }
+
+    template <class... Args>
+    static void construct(T* place, Args&&... args) {
+        ::new (static_cast<void*>(place)) T(std::forward<Args>(args)...);
+    }
+
+    inline T* inline_buffer() {
+        return reinterpret_cast<T*>(_inline);
+    }
+
+    inline size_t wrap(size_t pos) const {
+        return pos & (_capacity - 1);
+    }
+
+    inline void reset_to_inline() {
+        _buffer = inline_buffer();
+        _capacity = InlineN;
+        _head = 0;
+        _size = 0;
+    }
+
+    inline void release_heap_buffer() {
+        if (is_inline())
+            return;
+        deallocate(_buffer);
+        _buffer = inline_buffer();
+        _capacity = InlineN;
+    }
+
+    inline void relocate_elements(T* temp_buffer, std::true_type) {
+        size_t first_length = std::min(size(), _capacity - _head);
+        std::memcpy(static_cast<void*>(temp_buffer), _buffer + _head, first_length * sizeof(T));
+        std::memcpy(static_cast<void*>(temp_buffer + first_length), _buffer, (size() - first_length) * sizeof(T));
+    }
+
+    // Elements are moved into temp_buffer unless their move constructor may throw,
+    // in which case they are copied. On exception the deque is left untouched.
+    inline void relocate_elements(T* temp_buffer, std::false_type) {
+        size_t constructed = 0;
+        try {
+            for (; constructed < size(); ++constructed)
+                construct(temp_buffer + constructed, std::move_if_noexcept((*this)[constructed]));
+        } catch (...) {
+            for (size_t i = 0; i < constructed; ++i)
+                temp_buffer[i].~T();
+            throw;
+        }
+    }
+
+    inline void destroy_elements() {
+        for (size_t i = 0; i < size(); ++i)
+            (*this)[i].~T();
+    }
+
+    // Moves the elements to the front of temp_buffer and makes it the ring.
+    // On exception temp_buffer is still owned by the caller.
+    inline void relocate(T* temp_buffer, size_t new_capacity) {
+        relocate_elements(temp_buffer, trivially_copyable());
+        if (!trivially_copyable::value)
+            destroy_elements();
+        release_heap_buffer();
+        _buffer = temp_buffer;
+        _capacity = new_capacity;
+        _head = 0;
+    }
+
+    // The switch between the inline buffer and the heap happens here: a capacity of at most
+    // InlineN means the inline buffer. Moving from the inline buffer into itself does nothing.
+    inline void realloc(size_t new_capacity) {
+        if (new_capacity <= InlineN) {
+            if (is_inline())
+                return;
+            relocate(inline_buffer(), InlineN);
+            return;
+        }
+        T* temp_buffer = allocate(new_capacity);
+        try {
+            relocate(temp_buffer, new_capacity);
+        } catch (...) {
+            deallocate(temp_buffer);
+            throw;
+        }
+    }
+
+    // The new element is constructed in the new buffer before the old elements are moved,
+    // so args may refer to an element of this deque
+    template <class... Args>
+    void grow_and_emplace(bool at_front, Args&&... args) {
+        size_t new_capacity = _capacity << Policy::GROWTH_SHIFT;
+        T* temp_buffer = allocate(new_capacity);
+        size_t slot = at_front ? new_capacity - 1 : size();
+
+        try {
+            construct(temp_buffer + slot, std::forward<Args>(args)...);
+        } catch (...) {
+            deallocate(temp_buffer);
+            throw;
+        }
+        try {
+            relocate(temp_buffer, new_capacity);
+        } catch (...) {
+            temp_buffer[slot].~T();
+            deallocate(temp_buffer);
+            throw;
+        }
+
+        if (at_front)
+            _head = slot;
+        ++_size;
+    }
+
+    inline void try_to_decrease_capacity() {
+        if (is_inline() || !(size() < _capacity / Policy::SHRINK_THRESHOLD))
+            return;
+        realloc(_capacity >> Policy::SHRINK_SHIFT);
+    }
+
+    // Takes the heap ring of other, or moves its inline elements one by one; other is left empty
+    inline void move_elements_from(SmallDeque& other) {
+        if (other.is_inline()) {
+            for (; _size < other.size(); ++_size)
+                construct(_buffer + _size, std::move(other[_size]));
+            other.clear();
+            return;
+        }
+        _buffer = other._buffer;
+        _capacity = other._capacity;
+        _head = other._head;
+        _size = other._size;
+        other.reset_to_inline();
+    }
+
+public:
+
+    // Typedef iterators
+
+    typedef DequeIterator<SmallDeque, T> iterator;
+    typedef DequeIterator<const SmallDeque, const T> const_iterator;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    // Constructors & destructors
+
+    SmallDeque() {
+        reset_to_inline();
+    }
+
+    SmallDeque(std::initializer_list<T> elems) {
+        reset_to_inline();
+        reserve(elems.size());
+        for (const T& elem : elems)
+            push_back(elem);
+    }
+
+    SmallDeque(const SmallDeque& other) {
+        reset_to_inline();
+        reserve(other.size());
+        try {
+            for (; _size < other.size(); ++_size)
+                construct(_buffer + _size, other[_size]);
+        } catch (...) {
+            destroy_elements();
+            release_heap_buffer();
+            throw;
+        }
+    }
+
+    SmallDeque(SmallDeque&& other) noexcept(std::is_nothrow_move_constructible<T>::value) {
+        reset_to_inline();
+        move_elements_from(other);
+    }
+
+    ~SmallDeque() {
+        destroy_elements();
+        release_heap_buffer();
+    }
+
+    SmallDeque& operator =(const SmallDeque& other) {
+        if (this == &other)
+            return *this;
+        SmallDeque temp(other);
+        return *this = std::move(temp);
+    }
+
+    SmallDeque& operator =(SmallDeque&& other) {
+        if (this == &other)
+            return *this;
+        destroy_elements();
+        release_heap_buffer();
+        reset_to_inline();
+        move_elements_from(other);
+        return *this;
+    }
+
+    // Element access
+
+    T& at(size_t pos) {
+        if (!(pos < size())) {
+            throw std::out_of_range("SmallDeque::out of range, pos(" + std::to_string(pos) + ") >= size (" + std::to_string(size()) + ")");
+        }
+        return (*this)[pos];
+    }
+
+    const T& at(size_t pos) const {
+        if (!(pos < size())) {
+            throw std::out_of_range("SmallDeque::out of range, pos(" + std::to_string(pos) + ") >= size (" + std::to_string(size()) + ")");
+        }
+        return (*this)[pos];
+    }
+
+    T& operator [](size_t pos) {
+        return _buffer[wrap(_head + pos)];
+    }
+
+    const T& operator [](size_t pos) const {
+        return _buffer[wrap(_head + pos)];
+    }
+
+    T& front() {
+        return (*this)[0];
+    }
+
+    const T& front() const {
+        return (*this)[0];
+    }
+
+    T& back() {
+        return (*this)[size() - 1];
+    }
+
+    const T& back() const {
+        return (*this)[size() - 1];
+    }
+
+    // Contiguous storage
+
+    DequeSegments<T*> segments() {
+        size_t first_length = std::min(size(), _capacity - _head);
+        DequeSegments<T*> result = {{_buffer + _head, first_length}, {_buffer, size() - first_length}};
+        return result;
+    }
+
+    DequeSegments<const T*> segments() const {
+        size_t first_length = std::min(size(), _capacity - _head);
+        DequeSegments<const T*> result = {{_buffer + _head, first_length}, {_buffer, size() - first_length}};
+        return result;
+    }
+
+    // Capacity
+
+    bool empty() const {
+        return !size();
+    }
+
+    size_t size() const {
+        return _size;
+    }
+
+    size_t capacity() const {
+        return _capacity;
+    }
+
+    // True while the elements are stored inside the object
+    bool is_inline() const {
+        return _buffer == reinterpret_cast<const T*>(_inline);
+    }
+
+    void reserve(size_t new_capacity) {
+        if (new_capacity <= _capacity)
+            return;
+        size_t capacity = _capacity;
+        while (capacity < new_capacity)
+            capacity <<= Policy::GROWTH_SHIFT;
+        realloc(capacity);
+    }
+
+    // Moves the elements back into the inline buffer if they fit there
+    void shrink_to_fit() {
+        size_t new_capacity = InlineN;
+        while (new_capacity < size())
+            new_capacity <<= 1;
+        if (new_capacity < _capacity)
+            realloc(new_capacity);
+    }
+
+    // Modifiers
+
+    // Destroys the elements, but keeps the current buffer
+    void clear() {
+        destroy_elements();
+        _head = 0;
+        _size = 0;
+    }
+
+    template <class... Args>
+    T& emplace_back(Args&&... args) {
+        if (size() == _capacity) {
+            grow_and_emplace(false, std::forward<Args>(args)...);
+            return back();
+        }
+        construct(_buffer + wrap(_head + _size), std::forward<Args>(args)...);
+        ++_size;
+        return back();
+    }
+
+    void push_back(const T& elem) {
+        emplace_back(elem);
+    }
+
+    void push_back(T&& elem) {
+        emplace_back(std::move(elem));
+    }
+
+    void pop_back() {
+        --_size;
+        _buffer[wrap(_head + _size)].~T();
+        try_to_decrease_capacity();
+    }
+
+    template <class... Args>
+    T& emplace_front(Args&&... args) {
+        if (size() == _capacity) {
+            grow_and_emplace(true, std::forward<Args>(args)...);
+            return front();
+        }
+        size_t new_head = wrap(_head - 1);
+        construct(_buffer + new_head, std::forward<Args>(args)...);
+        _head = new_head;
+        ++_size;
+        return front();
+    }
+
+    void push_front(const T& elem) {
+        emplace_front(elem);
+    }
+
+    void push_front(T&& elem) {
+        emplace_front(std::move(elem));
+    }
+
+    void pop_front() {
+        _buffer[_head].~T();
+        _head = wrap(_head + 1);
+        --_size;
+        try_to_decrease_capacity();
+    }
+
+    // Iterators
+
+    iterator begin() {
+        return iterator(this, 0);
+    }
+
+    const_iterator begin() const {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator cbegin() const {
+        return const_iterator(this, 0);
+    }
+
+    iterator end() {
+        return iterator(this, size());
+    }
+
+    const_iterator end() const {
+        return const_iterator(this, size());
+    }
+
+    const_iterator cend() const {
+        return const_iterator(this, size());
+    }
+
+    reverse_iterator rbegin() {
+        return reverse_iterator(end());
+    }
+
+    const_reverse_iterator rbegin() const {
+        return const_reverse_iterator(cend());
+    }
+
+    reverse_iterator rend() {
+        return reverse_iterator(begin());
+    }
+
+    const_reverse_iterator rend() const {
+        return const_reverse_iterator(cbegin());
+    }
+};
+
+#endif //DEQUE_SMALL_DEQUE_H
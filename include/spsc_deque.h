@@ -0,0 +1,188 @@
+//
+// Created by anton on 17.10.26.
+//
+
+#ifndef DEQUE_SPSC_DEQUE_H
+#define DEQUE_SPSC_DEQUE_H
+
+#include <stdexcept>
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <utility>
+
+#include "deque_policy.h"
+
+// Lock-free bounded queue for exactly one producer thread and one consumer thread.
+//
+// The ring is laid out as in Deque: a power-of-two buffer, positions wrap with a mask, the
+// consumer owns _head and the producer owns _tail. The indices are never wrapped themselves,
+// so tail - head is the size and all capacity() slots are usable.
+//
+// Each index is published with a release store and read by the other side with an acquire load,
+// which makes the element constructed (or destroyed) before the store visible after the load.
+// Each side also keeps a cached copy of the other's index and reloads it only when the cached value
+// says the ring is full (or empty), so in the common case a push or a pop touches no shared cache line
+// other than the slot. The bulk operations move many elements and publish them with one store.
+template <class T>
+class SpscDeque {
+
+private:
+
+    // Written only in the constructor
+    T* _buffer;
+    size_t _capacity;
+
+    // Consumer side
+    alignas(DEQUE_CACHE_LINE_SIZE) std::atomic<size_t> _head;
+    size_t _tail_cache;
+
+    // Producer side
+    alignas(DEQUE_CACHE_LINE_SIZE) std::atomic<size_t> _tail;
+    size_t _head_cache;
+
+    inline size_t wrap(size_t pos) const {
+        return pos & (_capacity - 1);
+    }
+
+    template <class... Args>
+    inline void construct(size_t pos, Args&&... args) {
+        ::new (static_cast<void*>(_buffer + wrap(pos))) T(std::forward<Args>(args)...);
+    }
+
+    // Free slots as seen by the producer, refreshing the cached head only if fewer than wanted
+    inline size_t free_slots(size_t tail, size_t wanted) {
+        size_t free = _capacity - (tail - _head_cache);
+        if (free < wanted) {
+            _head_cache = _head.load(std::memory_order_acquire);
+            free = _capacity - (tail - _head_cache);
+        }
+        return free;
+    }
+
+    // Published elements as seen by the consumer, refreshing the cached tail only if fewer than wanted
+    inline size_t ready_slots(size_t head, size_t wanted) {
+        size_t ready = _tail_cache - head;
+        if (ready < wanted) {
+            _tail_cache = _tail.load(std::memory_order_acquire);
+            ready = _tail_cache - head;
+        }
+        return ready;
+    }
+
+public:
+
+    // Constructors & destructors
+
+    // The capacity is rounded up to a power of two
+    explicit SpscDeque(size_t capacity) : _head(0), _tail_cache(0), _tail(0), _head_cache(0) {
+        if (capacity == 0)
+            throw std::invalid_argument("SpscDeque::capacity must be positive");
+        _capacity = 1;
+        while (_capacity < capacity)
+            _capacity <<= 1;
+        _buffer = static_cast<T*>(::operator new(_capacity * sizeof(T)));
+    }
+
+    SpscDeque(const SpscDeque&) = delete;
+
+    SpscDeque& operator =(const SpscDeque&) = delete;
+
+    // Neither thread may use the deque any more
+    ~SpscDeque() {
+        size_t tail = _tail.load(std::memory_order_acquire);
+        for (size_t pos = _head.load(std::memory_order_relaxed); pos != tail; ++pos)
+            _buffer[wrap(pos)].~T();
+        ::operator delete(_buffer);
+    }
+
+    // Capacity
+
+    size_t capacity() const {
+        return _capacity;
+    }
+
+    // Exact only when called by one of the two threads while the other one is idle
+    size_t size_approx() const {
+        size_t head = _head.load(std::memory_order_acquire);
+        return _tail.load(std::memory_order_acquire) - head;
+    }
+
+    bool empty_approx() const {
+        return size_approx() == 0;
+    }
+
+    // Producer
+
+    template <class... Args>
+    bool try_emplace(Args&&... args) {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        if (free_slots(tail, 1) == 0)
+            return false;
+        construct(tail, std::forward<Args>(args)...);
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_push(const T& elem) {
+        return try_emplace(elem);
+    }
+
+    bool try_push(T&& elem) {
+        return try_emplace(std::move(elem));
+    }
+
+    // Pushes the first elements of [first, first + count), as many as fit, and publishes them at once.
+    // Returns the number of elements pushed. If a constructor throws, the elements before it are published.
+    template <class InputIt>
+    size_t try_push_n(InputIt first, size_t count) {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        count = std::min(count, free_slots(tail, count));
+        size_t pushed = 0;
+        try {
+            for (; pushed < count; ++pushed, ++first)
+                construct(tail + pushed, *first);
+        } catch (...) {
+            _tail.store(tail + pushed, std::memory_order_release);
+            throw;
+        }
+        _tail.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+    // Consumer
+
+    bool try_pop(T& out) {
+        size_t head = _head.load(std::memory_order_relaxed);
+        if (ready_slots(head, 1) == 0)
+            return false;
+        T& slot = _buffer[wrap(head)];
+        out = std::move(slot);
+        slot.~T();
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Moves up to count elements to out and releases their slots at once.
+    // Returns the number of elements popped. If an assignment throws, that element stays in the deque.
+    template <class OutputIt>
+    size_t try_pop_n(OutputIt out, size_t count) {
+        size_t head = _head.load(std::memory_order_relaxed);
+        count = std::min(count, ready_slots(head, count));
+        size_t popped = 0;
+        try {
+            for (; popped < count; ++popped, ++out) {
+                T& slot = _buffer[wrap(head + popped)];
+                *out = std::move(slot);
+                slot.~T();
+            }
+        } catch (...) {
+            _head.store(head + popped, std::memory_order_release);
+            throw;
+        }
+        _head.store(head + count, std::memory_order_release);
+        return count;
+    }
+};
+
+#endif //DEQUE_SPSC_DEQUE_H
@@ -0,0 +1,365 @@
+//
+// Created by anton on 17.10.26.
+//
+
+#ifndef DEQUE_STATIC_DEQUE_H
+#define DEQUE_STATIC_DEQUE_H
+
+#include <stdexcept>
+#include <string>
+#include <algorithm>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "deque_iterator.h"
+#include "deque_policy.h"
+#include "deque_segment.h"
+
+// Inline storage of StaticDeque. Trivial types are kept in a plain array, so that the deque
+// can be used in constant expressions; other types are constructed in raw storage on demand.
+template <class T, size_t N, bool Trivial = std::is_trivial<T>::value>
+class StaticDequeStorage {
+
+private:
+
+    T _data[N] = {};
+
+public:
+
+    DEQUE_CONSTEXPR20 T* slot(size_t pos) {
+        return _data + pos;
+    }
+
+    DEQUE_CONSTEXPR20 const T* slot(size_t pos) const {
+        return _data + pos;
+    }
+
+    template <class... Args>
+    DEQUE_CONSTEXPR20 void construct(size_t pos, Args&&... args) {
+        _data[pos] = T(std::forward<Args>(args)...);
+    }
+
+    DEQUE_CONSTEXPR20 void destroy(size_t) {}
+};
+
+template <class T, size_t N>
+class StaticDequeStorage<T, N, false> {
+
+private:
+
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type _data[N];
+
+public:
+
+    T* slot(size_t pos) {
+        return reinterpret_cast<T*>(_data + pos);
+    }
+
+    const T* slot(size_t pos) const {
+        return reinterpret_cast<const T*>(_data + pos);
+    }
+
+    template <class... Args>
+    void construct(size_t pos, Args&&... args) {
+        ::new (static_cast<void*>(_data + pos)) T(std::forward<Args>(args)...);
+    }
+
+    void destroy(size_t pos) {
+        slot(pos)->~T();
+    }
+};
+
+// Deque of at most N elements stored inside the object itself, without any heap allocation.
+//
+// N must be a power of two, so positions wrap with a compile-time mask, and all N slots are usable.
+// Pushing into a full deque follows the Overflow policy. Pushes return false when the new element
+// was dropped or another one was evicted for it, true otherwise.
+template <class T, size_t N, DequeOverflowPolicy Overflow = DEQUE_OVERFLOW_THROW>
+class StaticDeque {
+
+private:
+
+    static_assert(N > 0 && (N & (N - 1)) == 0, "StaticDeque: N must be a power of two");
+
+    typedef std::integral_constant<DequeOverflowPolicy, Overflow> overflow_tag;
+    typedef std::integral_constant<DequeOverflowPolicy, DEQUE_OVERFLOW_THROW> throw_tag;
+    typedef std::integral_constant<DequeOverflowPolicy, DEQUE_OVERFLOW_FAIL> fail_tag;
+    typedef std::integral_constant<DequeOverflowPolicy, DEQUE_OVERFLOW_OVERWRITE> overwrite_tag;
+
+    StaticDequeStorage<T, N> _storage;
+
+    size_t _head = 0;
+    size_t _size = 0;
+
+    DEQUE_CONSTEXPR20 inline size_t wrap(size_t pos) const {
+        return pos & (N - 1);
+    }
+
+    template <class... Args>
+    bool overflow_back(throw_tag, Args&&...) {
+        throw std::length_error("StaticDeque::overflow, size (" + std::to_string(N) + ") == capacity (" +
+                                std::to_string(N) + ")");
+    }
+
+    template <class... Args>
+    DEQUE_CONSTEXPR20 bool overflow_back(fail_tag, Args&&...) {
+        return false;
+    }
+
+    // The new element is built before the eviction, since the arguments may refer to the evicted one
+    template <class... Args>
+    DEQUE_CONSTEXPR20 bool overflow_back(overwrite_tag, Args&&... args) {
+        T elem(std::forward<Args>(args)...);
+        pop_front();
+        _storage.construct(wrap(_head + _size), std::move(elem));
+        ++_size;
+        return false;
+    }
+
+    template <class... Args>
+    bool overflow_front(throw_tag, Args&&... args) {
+        return overflow_back(throw_tag(), std::forward<Args>(args)...);
+    }
+
+    template <class... Args>
+    DEQUE_CONSTEXPR20 bool overflow_front(fail_tag, Args&&...) {
+        return false;
+    }
+
+    template <class... Args>
+    DEQUE_CONSTEXPR20 bool overflow_front(overwrite_tag, Args&&... args) {
+        T elem(std::forward<Args>(args)...);
+        pop_back();
+        _head = wrap(_head - 1);
+        _storage.construct(_head, std::move(elem));
+        ++_size;
+        return false;
+    }
+
+public:
+
+    // Typedef iterators
+
+    typedef DequeIterator<StaticDeque, T> iterator;
+    typedef DequeIterator<const StaticDeque, const T> const_iterator;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    // Constructors & destructors
+
+    DEQUE_CONSTEXPR20 StaticDeque() {}
+
+    DEQUE_CONSTEXPR20 StaticDeque(std::initializer_list<T> elems) {
+        for (const T& elem : elems)
+            push_back(elem);
+    }
+
+    DEQUE_CONSTEXPR20 StaticDeque(const StaticDeque& other) {
+        for (; _size < other.size(); ++_size)
+            _storage.construct(_size, other[_size]);
+    }
+
+    // Moves the elements one by one, other is left empty
+    DEQUE_CONSTEXPR20 StaticDeque(StaticDeque&& other) {
+        for (; _size < other.size(); ++_size)
+            _storage.construct(_size, std::move(other[_size]));
+        other.clear();
+    }
+
+    DEQUE_CONSTEXPR20 ~StaticDeque() {
+        clear();
+    }
+
+    DEQUE_CONSTEXPR20 StaticDeque& operator =(const StaticDeque& other) {
+        if (this == &other)
+            return *this;
+        clear();
+        for (; _size < other.size(); ++_size)
+            _storage.construct(_size, other[_size]);
+        return *this;
+    }
+
+    DEQUE_CONSTEXPR20 StaticDeque& operator =(StaticDeque&& other) {
+        if (this == &other)
+            return *this;
+        clear();
+        for (; _size < other.size(); ++_size)
+            _storage.construct(_size, std::move(other[_size]));
+        other.clear();
+        return *this;
+    }
+
+    // Element access
+
+    T& at(size_t pos) {
+        if (!(pos < size())) {
+            throw std::out_of_range("StaticDeque::out of range, pos(" + std::to_string(pos) + ") >= size (" + std::to_string(size()) + ")");
+        }
+        return (*this)[pos];
+    }
+
+    const T& at(size_t pos) const {
+        if (!(pos < size())) {
+            throw std::out_of_range("StaticDeque::out of range, pos(" + std::to_string(pos) + ") >= size (" + std::to_string(size()) + ")");
+        }
+        return (*this)[pos];
+    }
+
+    DEQUE_CONSTEXPR20 T& operator [](size_t pos) {
+        return *_storage.slot(wrap(_head + pos));
+    }
+
+    DEQUE_CONSTEXPR20 const T& operator [](size_t pos) const {
+        return *_storage.slot(wrap(_head + pos));
+    }
+
+    DEQUE_CONSTEXPR20 T& front() {
+        return (*this)[0];
+    }
+
+    DEQUE_CONSTEXPR20 const T& front() const {
+        return (*this)[0];
+    }
+
+    DEQUE_CONSTEXPR20 T& back() {
+        return (*this)[size() - 1];
+    }
+
+    DEQUE_CONSTEXPR20 const T& back() const {
+        return (*this)[size() - 1];
+    }
+
+    // Contiguous storage
+
+    DEQUE_CONSTEXPR20 DequeSegments<T*> segments() {
+        size_t first_length = std::min(size(), N - _head);
+        DequeSegments<T*> result = {{_storage.slot(_head), first_length}, {_storage.slot(0), size() - first_length}};
+        return result;
+    }
+
+    DEQUE_CONSTEXPR20 DequeSegments<const T*> segments() const {
+        size_t first_length = std::min(size(), N - _head);
+        DequeSegments<const T*> result = {{_storage.slot(_head), first_length}, {_storage.slot(0), size() - first_length}};
+        return result;
+    }
+
+    // Capacity
+
+    DEQUE_CONSTEXPR20 bool empty() const {
+        return !size();
+    }
+
+    DEQUE_CONSTEXPR20 bool full() const {
+        return size() == N;
+    }
+
+    DEQUE_CONSTEXPR20 size_t size() const {
+        return _size;
+    }
+
+    DEQUE_CONSTEXPR20 size_t capacity() const {
+        return N;
+    }
+
+    // Modifiers
+
+    DEQUE_CONSTEXPR20 void clear() {
+        while (!empty())
+            pop_back();
+        _head = 0;
+    }
+
+    template <class... Args>
+    DEQUE_CONSTEXPR20 bool emplace_back(Args&&... args) {
+        if (full())
+            return overflow_back(overflow_tag(), std::forward<Args>(args)...);
+        _storage.construct(wrap(_head + _size), std::forward<Args>(args)...);
+        ++_size;
+        return true;
+    }
+
+    DEQUE_CONSTEXPR20 bool push_back(const T& elem) {
+        return emplace_back(elem);
+    }
+
+    DEQUE_CONSTEXPR20 bool push_back(T&& elem) {
+        return emplace_back(std::move(elem));
+    }
+
+    DEQUE_CONSTEXPR20 void pop_back() {
+        --_size;
+        _storage.destroy(wrap(_head + _size));
+    }
+
+    template <class... Args>
+    DEQUE_CONSTEXPR20 bool emplace_front(Args&&... args) {
+        if (full())
+            return overflow_front(overflow_tag(), std::forward<Args>(args)...);
+        size_t new_head = wrap(_head - 1);
+        _storage.construct(new_head, std::forward<Args>(args)...);
+        _head = new_head;
+        ++_size;
+        return true;
+    }
+
+    DEQUE_CONSTEXPR20 bool push_front(const T& elem) {
+        return emplace_front(elem);
+    }
+
+    DEQUE_CONSTEXPR20 bool push_front(T&& elem) {
+        return emplace_front(std::move(elem));
+    }
+
+    DEQUE_CONSTEXPR20 void pop_front() {
+        _storage.destroy(_head);
+        _head = wrap(_head + 1);
+        --_size;
+    }
+
+    // Iterators
+
+    DEQUE_CONSTEXPR20 iterator begin() {
+        return iterator(this, 0);
+    }
+
+    DEQUE_CONSTEXPR20 const_iterator begin() const {
+        return const_iterator(this, 0);
+    }
+
+    DEQUE_CONSTEXPR20 const_iterator cbegin() const {
+        return const_iterator(this, 0);
+    }
+
+    DEQUE_CONSTEXPR20 iterator end() {
+        return iterator(this, size());
+    }
+
+    DEQUE_CONSTEXPR20 const_iterator end() const {
+        return const_iterator(this, size());
+    }
+
+    DEQUE_CONSTEXPR20 const_iterator cend() const {
+        return const_iterator(this, size());
+    }
+
+    DEQUE_CONSTEXPR20 reverse_iterator rbegin() {
+        return reverse_iterator(end());
+    }
+
+    DEQUE_CONSTEXPR20 const_reverse_iterator rbegin() const {
+        return const_reverse_iterator(cend());
+    }
+
+    DEQUE_CONSTEXPR20 reverse_iterator rend() {
+        return reverse_iterator(begin());
+    }
+
+    DEQUE_CONSTEXPR20 const_reverse_iterator rend() const {
+        return const_reverse_iterator(cbegin());
+    }
+};
+
+#endif //DEQUE_STATIC_DEQUE_H
@@ -1,9 +1,35 @@
 #include "deque.h"
+#include "bounded_deque.h"
+#include "concurrent_deque.h"
+#include "deque_algorithm.h"
+#include "fork_join_pool.h"
+#include "incremental_deque.h"
+#include "mirrored_deque.h"
+#include "mpmc_deque.h"
+#include "segmented_deque.h"
+#include "small_deque.h"
+#include "spsc_deque.h"
+#include "static_deque.h"
+#include "work_stealing_deque.h"
 
 #include <gtest/gtest.h>
 #include <time.h>
 #include <deque>
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
 
 enum ActionType {
     PUSH_BACK,
@@ -279,4 +305,2595 @@ TEST_F(TestDequeFixture, test_riterator_brackets) {
     for (int d = 0; d < CONTAINER_SIZE; ++d) {
         ASSERT_EQ(std_it[d], it[d]);
     }
-}
\ No newline at end of file
+}
+
+// Element lifetime tests
+
+struct CountedElement {
+    static int alive;
+    static int copies;
+
+    int value;
+
+    explicit CountedElement(int value) : value(value) {
+        ++alive;
+    }
+
+    CountedElement(const CountedElement& other) : value(other.value) {
+        ++alive;
+        ++copies;
+    }
+
+    CountedElement(CountedElement&& other) noexcept : value(other.value) {
+        ++alive;
+    }
+
+    CountedElement& operator =(const CountedElement& other) = default;
+
+    ~CountedElement() {
+        --alive;
+    }
+};
+
+int CountedElement::alive = 0;
+int CountedElement::copies = 0;
+
+TEST(TestDequeElements, test_elements_lifetime) {
+    CountedElement::alive = 0;
+    {
+        Deque<CountedElement> counted_dq;
+        std::deque<int> values;
+        for (int i = 0; i < 10000; ++i) {
+            int action = rand() % 4;
+            if (values.empty() || action < 2) {
+                int val = rand();
+                if (action % 2) {
+                    counted_dq.push_back(CountedElement(val));
+                    values.push_back(val);
+                } else {
+                    counted_dq.push_front(CountedElement(val));
+                    values.push_front(val);
+                }
+            } else if (action == 2) {
+                counted_dq.pop_back();
+                values.pop_back();
+            } else {
+                counted_dq.pop_front();
+                values.pop_front();
+            }
+            ASSERT_EQ(values.size(), (size_t)CountedElement::alive);
+        }
+        for (size_t i = 0; i < values.size(); ++i)
+            ASSERT_EQ(values[i], counted_dq[i].value);
+
+        Deque<CountedElement> copy(counted_dq);
+        ASSERT_EQ(2 * values.size(), (size_t)CountedElement::alive);
+        copy = counted_dq;
+        ASSERT_EQ(2 * values.size(), (size_t)CountedElement::alive);
+        for (size_t i = 0; i < values.size(); ++i)
+            ASSERT_EQ(values[i], copy[i].value);
+    }
+    ASSERT_EQ(0, CountedElement::alive);
+}
+
+TEST(TestDequeElements, test_realloc_moves_elements) {
+    const int COUNT = 100000;
+    Deque<CountedElement> counted_dq;
+    CountedElement elem(0);
+    CountedElement::copies = 0;
+    for (int i = 0; i < COUNT; ++i) {
+        elem.value = i;
+        i % 2 ? counted_dq.push_back(elem) : counted_dq.push_front(elem);
+    }
+    ASSERT_EQ(COUNT, CountedElement::copies);
+    for (int i = 0; i < COUNT; ++i)
+        counted_dq.pop_back();
+    ASSERT_EQ(COUNT, CountedElement::copies);
+}
+
+TEST(TestDequeElements, test_strings) {
+    Deque<std::string> str_dq;
+    std::deque<std::string> std_str_dq;
+    for (int i = 0; i < 10000; ++i) {
+        std::string val(rand() % 64, 'a' + rand() % 26);
+        if (rand() % 2) {
+            str_dq.push_back(val);
+            std_str_dq.push_back(val);
+        } else {
+            str_dq.push_front(val);
+            std_str_dq.push_front(val);
+        }
+    }
+    for (int i = 0; i < 5000; ++i) {
+        if (rand() % 2) {
+            str_dq.pop_back();
+            std_str_dq.pop_back();
+        } else {
+            str_dq.pop_front();
+            std_str_dq.pop_front();
+        }
+    }
+    ASSERT_EQ(std_str_dq.size(), str_dq.size());
+    for (size_t i = 0; i < std_str_dq.size(); ++i)
+        ASSERT_EQ(std_str_dq[i], str_dq[i]);
+}
+
+TEST(TestDequeElements, test_emplace) {
+    Deque<std::string> str_dq;
+    std::deque<std::string> std_str_dq;
+    for (int i = 0; i < 10000; ++i) {
+        size_t length = rand() % 64;
+        char letter = 'a' + rand() % 26;
+        if (rand() % 2) {
+            ASSERT_EQ(std::string(length, letter), str_dq.emplace_back(length, letter));
+            std_str_dq.emplace_back(length, letter);
+        } else {
+            ASSERT_EQ(std::string(length, letter), str_dq.emplace_front(length, letter));
+            std_str_dq.emplace_front(length, letter);
+        }
+    }
+    ASSERT_EQ(std_str_dq.size(), str_dq.size());
+    for (size_t i = 0; i < std_str_dq.size(); ++i)
+        ASSERT_EQ(std_str_dq[i], str_dq[i]);
+}
+
+TEST(TestDequeElements, test_move_only_elements) {
+    Deque<std::unique_ptr<int>> ptr_dq;
+    for (int i = 0; i < 10000; ++i) {
+        ptr_dq.push_back(std::unique_ptr<int>(new int(i)));
+        ptr_dq.emplace_front(new int(-i));
+    }
+    for (int i = 0; i < 10000; ++i) {
+        ASSERT_EQ(-i, *ptr_dq[9999 - i]);
+        ASSERT_EQ(i, *ptr_dq[10000 + i]);
+    }
+    while (!ptr_dq.empty()) {
+        std::unique_ptr<int> taken = std::move(ptr_dq.front());
+        ptr_dq.pop_front();
+        ASSERT_TRUE(taken != nullptr);
+    }
+}
+
+TEST(TestDequeElements, test_push_own_element) {
+    Deque<std::string> str_dq;
+    std::deque<std::string> std_str_dq;
+    str_dq.push_back(std::string(32, 'x'));
+    std_str_dq.push_back(std::string(32, 'x'));
+    for (int i = 0; i < 1000; ++i) {
+        str_dq.push_back(str_dq.front());
+        std_str_dq.push_back(std_str_dq.front());
+        str_dq.push_front(str_dq.back());
+        std_str_dq.push_front(std_str_dq.back());
+        str_dq.back() += 'y';
+        std_str_dq.back() += 'y';
+    }
+    for (size_t i = 0; i < std_str_dq.size(); ++i)
+        ASSERT_EQ(std_str_dq[i], str_dq[i]);
+}
+
+TEST(TestDequeElements, test_power_of_two_shrink_to_fit) {
+    Deque<int> fitted_dq;
+    std::deque<int> std_fitted_dq;
+    for (int i = 0; i < 1000; ++i) {
+        fitted_dq.push_back(i);
+        std_fitted_dq.push_back(i);
+        fitted_dq.shrink_to_fit();
+        fitted_dq.push_front(-i);
+        std_fitted_dq.push_front(-i);
+    }
+    for (int i = 0; i < 1500; ++i) {
+        fitted_dq.pop_front();
+        std_fitted_dq.pop_front();
+        fitted_dq.shrink_to_fit();
+    }
+    ASSERT_EQ(std_fitted_dq.size(), fitted_dq.size());
+    for (size_t i = 0; i < std_fitted_dq.size(); ++i)
+        ASSERT_EQ(std_fitted_dq[i], fitted_dq[i]);
+}
+
+
+struct QuadrupleGrowthPolicy : DequeGrowthPolicy {
+    static const size_t MIN_CAPACITY = 16;
+    static const size_t GROWTH_SHIFT = 2;
+    static const size_t SHRINK_SHIFT = 2;
+    static const size_t SHRINK_THRESHOLD = 8;
+};
+
+TEST(TestDequeElements, test_custom_growth_policy) {
+    Deque<int, QuadrupleGrowthPolicy> policy_dq;
+    std::deque<int> std_policy_dq;
+    std::vector<ActionType> actions;
+    generate_actions(actions, 100000);
+    for (size_t i = 0; i < actions.size(); ++i) {
+        int val = rand();
+        if (actions[i] == PUSH_BACK) {
+            policy_dq.push_back(val);
+            std_policy_dq.push_back(val);
+        } else if (actions[i] == PUSH_FRONT) {
+            policy_dq.push_front(val);
+            std_policy_dq.push_front(val);
+        } else if (actions[i] == POP_BACK) {
+            policy_dq.pop_back();
+            std_policy_dq.pop_back();
+        } else {
+            policy_dq.pop_front();
+            std_policy_dq.pop_front();
+        }
+    }
+    ASSERT_EQ(std_policy_dq.size(), policy_dq.size());
+    for (size_t i = 0; i < std_policy_dq.size(); ++i)
+        ASSERT_EQ(std_policy_dq[i], policy_dq[i]);
+}
+
+TEST(TestDequeElements, test_incremental_deque) {
+    CountedElement::alive = 0;
+    {
+        IncrementalDeque<CountedElement> incremental_dq;
+        std::deque<int> values;
+        std::vector<ActionType> actions;
+        generate_actions(actions, 100000);
+        for (size_t i = 0; i < actions.size(); ++i) {
+            int val = rand();
+            if (actions[i] == PUSH_BACK) {
+                incremental_dq.emplace_back(val);
+                values.push_back(val);
+            } else if (actions[i] == PUSH_FRONT) {
+                incremental_dq.emplace_front(val);
+                values.push_front(val);
+            } else if (actions[i] == POP_BACK) {
+                incremental_dq.pop_back();
+                values.pop_back();
+            } else {
+                incremental_dq.pop_front();
+                values.pop_front();
+            }
+            ASSERT_EQ(values.size(), incremental_dq.size());
+            ASSERT_EQ(values.size(), (size_t)CountedElement::alive);
+            if (!values.empty()) {
+                ASSERT_EQ(values.front(), incremental_dq.front().value);
+                ASSERT_EQ(values.back(), incremental_dq.back().value);
+            }
+            if (i % 1000 == 0) {
+                for (size_t j = 0; j < values.size(); ++j)
+                    ASSERT_EQ(values[j], incremental_dq[j].value);
+            }
+        }
+        IncrementalDeque<CountedElement> copy(incremental_dq);
+        for (size_t j = 0; j < values.size(); ++j)
+            ASSERT_EQ(values[j], copy[j].value);
+        while (!incremental_dq.empty())
+            incremental_dq.pop_front();
+        ASSERT_EQ(values.size(), (size_t)CountedElement::alive);
+    }
+    ASSERT_EQ(0, CountedElement::alive);
+}
+
+// Stateful allocator that counts the elements it has handed out
+template <class T>
+struct CountingAllocator {
+    typedef T value_type;
+    typedef std::true_type propagate_on_container_copy_assignment;
+
+    long long* allocated;
+    int id;
+
+    CountingAllocator(long long* allocated, int id) : allocated(allocated), id(id) {}
+
+    template <class U>
+    CountingAllocator(const CountingAllocator<U>& other) : allocated(other.allocated), id(other.id) {}
+
+    T* allocate(size_t n) {
+        *allocated += n;
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, size_t n) {
+        *allocated -= n;
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    bool operator ==(const CountingAllocator& other) const {
+        return allocated == other.allocated && id == other.id;
+    }
+
+    bool operator !=(const CountingAllocator& other) const {
+        return !(*this == other);
+    }
+};
+
+TEST(TestDequeElements, test_allocator) {
+    typedef Deque<std::string, DequeGrowthPolicy, CountingAllocator<std::string>> CountedDeque;
+    long long allocated_first = 0, allocated_second = 0;
+    {
+        CountedDeque first(CountingAllocator<std::string>(&allocated_first, 1));
+        for (int i = 0; i < 1000; ++i)
+            i % 2 ? first.push_back(std::to_string(i)) : first.push_front(std::to_string(i));
+        ASSERT_LT(0, allocated_first);
+
+        CountedDeque copy(first);
+        ASSERT_EQ(1, copy.get_allocator().id);
+
+        CountedDeque second(CountingAllocator<std::string>(&allocated_second, 2));
+        second.push_back("second");
+        ASSERT_LT(0, allocated_second);
+        second = first;
+        ASSERT_EQ(0, allocated_second);
+        ASSERT_EQ(1, second.get_allocator().id);
+        for (size_t i = 0; i < first.size(); ++i)
+            ASSERT_EQ(first[i], second[i]);
+        while (second.size() > 10)
+            second.pop_back();
+    }
+    ASSERT_EQ(0, allocated_first);
+    ASSERT_EQ(0, allocated_second);
+}
+
+TEST(TestDequeElements, test_move_and_swap) {
+    Deque<std::string> source;
+    for (int i = 0; i < 1000; ++i)
+        source.push_back(std::string(40, 'a' + i % 26));
+    const std::string* first_element = &source[0];
+
+    Deque<std::string> moved(std::move(source));
+    ASSERT_EQ(first_element, &moved[0]);
+    ASSERT_EQ(1000u, moved.size());
+    ASSERT_TRUE(source.empty());
+
+    // A moved-from deque stays usable
+    source.push_front("front");
+    source.push_back("back");
+    ASSERT_EQ("front", source.front());
+    ASSERT_EQ("back", source.back());
+
+    source = std::move(moved);
+    ASSERT_EQ(first_element, &source[0]);
+    ASSERT_TRUE(moved.empty());
+
+    Deque<std::string> other;
+    other.push_back("other");
+    swap(source, other);
+    ASSERT_EQ(1u, source.size());
+    ASSERT_EQ("other", source[0]);
+    ASSERT_EQ(first_element, &other[0]);
+    other.swap(source);
+    ASSERT_EQ(first_element, &source[0]);
+
+    Deque<std::string> copy_of_moved_from(moved);
+    copy_of_moved_from.push_back("copied");
+    ASSERT_EQ(1u, copy_of_moved_from.size());
+
+    std::vector<Deque<std::string>> deques;
+    for (int i = 0; i < 100; ++i) {
+        deques.push_back(source);
+        ASSERT_EQ(first_element, &source[0]);
+    }
+    for (size_t i = 0; i < deques.size(); ++i)
+        ASSERT_EQ(source.size(), deques[i].size());
+}
+
+TEST(TestDequeElements, test_clear_and_reserve) {
+    CountedElement::alive = 0;
+    {
+        Deque<CountedElement> counted_dq;
+        counted_dq.reserve(1000);
+        size_t reserved = counted_dq.capacity();
+        ASSERT_LE(1000u, reserved);
+        for (int cycle = 0; cycle < 10; ++cycle) {
+            const CountedElement* first_element = nullptr;
+            for (int i = 0; i < 1000; ++i) {
+                i % 2 ? counted_dq.emplace_back(i) : counted_dq.emplace_front(i);
+                if (i == 0)
+                    first_element = &counted_dq[0];
+            }
+            ASSERT_EQ(1000, CountedElement::alive);
+            ASSERT_EQ(reserved, counted_dq.capacity());
+            // No reallocation happened, so the first pushed element did not move
+            ASSERT_EQ(0, counted_dq[499].value);
+            ASSERT_EQ(first_element, &counted_dq[499]);
+            counted_dq.clear();
+            ASSERT_EQ(0, CountedElement::alive);
+            ASSERT_TRUE(counted_dq.empty());
+            ASSERT_EQ(reserved, counted_dq.capacity());
+        }
+        counted_dq.reserve(10);
+        ASSERT_EQ(reserved, counted_dq.capacity());
+        for (int i = 0; i < 10; ++i)
+            counted_dq.emplace_back(i);
+        counted_dq.reserve(5000);
+        ASSERT_LE(5000u, counted_dq.capacity());
+        for (int i = 0; i < 10; ++i)
+            ASSERT_EQ(i, counted_dq[i].value);
+    }
+    ASSERT_EQ(0, CountedElement::alive);
+}
+
+TEST(TestDequeElements, test_append_prepend) {
+    Deque<int> range_dq;
+    std::deque<int> std_range_dq;
+    for (int step = 0; step < 200; ++step) {
+        std::vector<int> values(rand() % 100);
+        for (size_t i = 0; i < values.size(); ++i)
+            values[i] = rand();
+        std::list<int> values_list(values.begin(), values.end());
+        const std::vector<int>& const_values = values;
+        switch (rand() % 5) {
+            case 0:
+                range_dq.append(values.data(), values.data() + values.size());
+                std_range_dq.insert(std_range_dq.end(), values.begin(), values.end());
+                break;
+            case 1:
+                range_dq.prepend(values.begin(), values.end());
+                std_range_dq.insert(std_range_dq.begin(), values.begin(), values.end());
+                break;
+            case 2:
+                range_dq.append(values_list.begin(), values_list.end());
+                std_range_dq.insert(std_range_dq.end(), values.begin(), values.end());
+                break;
+            case 3:
+                range_dq.append(const_values.begin(), const_values.end());
+                std_range_dq.insert(std_range_dq.end(), values.begin(), values.end());
+                break;
+            default:
+                range_dq.prepend(values.data(), values.data() + values.size());
+                std_range_dq.insert(std_range_dq.begin(), values.begin(), values.end());
+                break;
+        }
+        for (int i = rand() % 50; i > 0 && !std_range_dq.empty(); --i) {
+            range_dq.pop_front();
+            std_range_dq.pop_front();
+        }
+        ASSERT_EQ(std_range_dq.size(), range_dq.size());
+        for (size_t i = 0; i < std_range_dq.size(); ++i)
+            ASSERT_EQ(std_range_dq[i], range_dq[i]);
+    }
+
+    // vector<bool> iterators are not contiguous and go element by element
+    std::vector<bool> flags = {true, false, true};
+    Deque<bool> flag_dq;
+    flag_dq.append(flags.begin(), flags.end());
+    ASSERT_EQ(3, flag_dq.size());
+    ASSERT_TRUE(flag_dq[0] && !flag_dq[1] && flag_dq[2]);
+}
+
+TEST(TestDequeElements, test_assign_insert_ranges) {
+    std::istringstream input("1 2 3 4 5");
+    Deque<int> range_dq(std::istream_iterator<int>(input), (std::istream_iterator<int>()));
+    ASSERT_EQ(5u, range_dq.size());
+    ASSERT_EQ(5, range_dq.back());
+
+    std::istringstream prefix("-2 -1 0");
+    range_dq.prepend(std::istream_iterator<int>(prefix), std::istream_iterator<int>());
+    int expected[] = {-2, -1, 0, 1, 2, 3, 4, 5};
+    ASSERT_EQ(8u, range_dq.size());
+    for (size_t i = 0; i < range_dq.size(); ++i)
+        ASSERT_EQ(expected[i], range_dq[i]);
+
+    range_dq.assign({7, 8, 9});
+    int middle[] = {100, 101};
+    Deque<int>::iterator inserted = range_dq.insert(range_dq.cbegin() + 1, middle, middle + 2);
+    ASSERT_EQ(100, *inserted);
+    inserted = range_dq.insert(range_dq.cend(), middle, middle + 1);
+    ASSERT_EQ(100, *inserted);
+    inserted = range_dq.insert(range_dq.cbegin(), middle + 1, middle + 2);
+    ASSERT_EQ(101, *inserted);
+    int after_insert[] = {101, 7, 100, 101, 8, 9, 100};
+    ASSERT_EQ(7u, range_dq.size());
+    for (size_t i = 0; i < range_dq.size(); ++i)
+        ASSERT_EQ(after_insert[i], range_dq[i]);
+
+    std::vector<std::string> words = {"a", "bb", "ccc"};
+    Deque<std::string> words_dq(words.begin(), words.end());
+    words_dq.prepend(words.begin(), words.end());
+    words_dq.insert(words_dq.cbegin() + 3, words.begin(), words.begin() + 1);
+    std::string expected_words[] = {"a", "bb", "ccc", "a", "a", "bb", "ccc"};
+    ASSERT_EQ(7u, words_dq.size());
+    for (size_t i = 0; i < words_dq.size(); ++i)
+        ASSERT_EQ(expected_words[i], words_dq[i]);
+}
+
+TEST(TestDequeElements, test_bulk_pop) {
+    Deque<std::string> bulk_dq;
+    std::deque<std::string> std_bulk_dq;
+    for (int step = 0; step < 300; ++step) {
+        for (int i = rand() % 200; i > 0; --i) {
+            std::string val = std::to_string(rand());
+            if (rand() % 2) {
+                bulk_dq.push_back(val);
+                std_bulk_dq.push_back(val);
+            } else {
+                bulk_dq.push_front(val);
+                std_bulk_dq.push_front(val);
+            }
+        }
+        size_t count = rand() % 250;
+        size_t popped = std::min(count, std_bulk_dq.size());
+        std::vector<std::string> out;
+        if (rand() % 2) {
+            bulk_dq.pop_front_n(count, std::back_inserter(out));
+            ASSERT_TRUE(std::equal(out.begin(), out.end(), std_bulk_dq.begin()));
+            std_bulk_dq.erase(std_bulk_dq.begin(), std_bulk_dq.begin() + popped);
+        } else {
+            bulk_dq.pop_back_n(count, std::back_inserter(out));
+            ASSERT_TRUE(std::equal(out.begin(), out.end(), std_bulk_dq.end() - popped));
+            std_bulk_dq.erase(std_bulk_dq.end() - popped, std_bulk_dq.end());
+        }
+        ASSERT_EQ(popped, out.size());
+        ASSERT_EQ(std_bulk_dq.size(), bulk_dq.size());
+        for (size_t i = 0; i < std_bulk_dq.size(); ++i)
+            ASSERT_EQ(std_bulk_dq[i], bulk_dq[i]);
+    }
+
+    CountedElement::alive = 0;
+    {
+        Deque<CountedElement> counted_dq;
+        for (int i = 0; i < 10000; ++i)
+            i % 2 ? counted_dq.emplace_back(i) : counted_dq.emplace_front(i);
+        std::vector<CountedElement> drained;
+        drained.reserve(10000);
+        counted_dq.drain_into(std::back_inserter(drained));
+        ASSERT_TRUE(counted_dq.empty());
+        ASSERT_GT(10000u, counted_dq.capacity());
+        ASSERT_EQ(10000, CountedElement::alive);
+        ASSERT_EQ(9998, drained.front().value);
+        ASSERT_EQ(9999, drained.back().value);
+    }
+    ASSERT_EQ(0, CountedElement::alive);
+
+    int ints[4096];
+    Deque<int> int_dq;
+    for (int i = 0; i < 10000; ++i)
+        int_dq.push_back(i);
+    int* end = int_dq.pop_front_n(4096, ints);
+    ASSERT_EQ(ints + 4096, end);
+    ASSERT_EQ(4095, ints[4095]);
+    ASSERT_EQ(4096, int_dq.front());
+}
+
+template <class Elem, class MakeElem>
+void check_middle_insert_erase(MakeElem make_elem) {
+    Deque<Elem> middle_dq;
+    std::deque<Elem> std_middle_dq;
+    for (int step = 0; step < 3000; ++step) {
+        size_t index = std_middle_dq.empty() ? 0 : rand() % (std_middle_dq.size() + 1);
+        int action = rand() % 6;
+        if (action == 0) {
+            Elem elem = make_elem(rand());
+            ASSERT_EQ(elem, *middle_dq.insert(middle_dq.begin() + index, elem));
+            std_middle_dq.insert(std_middle_dq.begin() + index, elem);
+        } else if (action == 1) {
+            std::vector<Elem> values;
+            for (int i = rand() % 20; i > 0; --i)
+                values.push_back(make_elem(rand()));
+            middle_dq.insert(middle_dq.cbegin() + index, values.begin(), values.end());
+            // libstdc++ std::deque self-move-assigns elements on an empty range insert
+            if (!values.empty())
+                std_middle_dq.insert(std_middle_dq.begin() + index, values.begin(), values.end());
+        } else if (action == 2) {
+            std::list<Elem> values;
+            for (int i = rand() % 20; i > 0; --i)
+                values.push_back(make_elem(rand()));
+            middle_dq.insert(middle_dq.cbegin() + index, values.begin(), values.end());
+            // libstdc++ std::deque self-move-assigns elements on an empty range insert
+            if (!values.empty())
+                std_middle_dq.insert(std_middle_dq.begin() + index, values.begin(), values.end());
+        } else if (action == 3 && index < std_middle_dq.size()) {
+            middle_dq.erase(middle_dq.begin() + index);
+            std_middle_dq.erase(std_middle_dq.begin() + index);
+        } else if (action == 4) {
+            size_t count = std::min(std_middle_dq.size() - index, (size_t)(rand() % 30));
+            middle_dq.erase(middle_dq.cbegin() + index, middle_dq.cbegin() + index + count);
+            std_middle_dq.erase(std_middle_dq.begin() + index, std_middle_dq.begin() + index + count);
+        } else {
+            Elem elem = make_elem(rand());
+            middle_dq.emplace(middle_dq.cbegin() + index, elem);
+            std_middle_dq.emplace(std_middle_dq.begin() + index, elem);
+        }
+        ASSERT_EQ(std_middle_dq.size(), middle_dq.size());
+        for (size_t i = 0; i < std_middle_dq.size(); ++i)
+            ASSERT_EQ(std_middle_dq[i], middle_dq[i]);
+    }
+}
+
+int make_int(int val) {
+    return val;
+}
+
+std::string make_string(int val) {
+    return std::to_string(val);
+}
+
+TEST(TestDequeElements, test_middle_insert_erase) {
+    check_middle_insert_erase<int>(make_int);
+    check_middle_insert_erase<std::string>(make_string);
+}
+
+TEST(TestDequeElements, test_erase_if) {
+    Deque<int> filtered_dq;
+    for (int i = 0; i < 1000; ++i)
+        i % 2 ? filtered_dq.push_back(i) : filtered_dq.push_front(i);
+    ASSERT_EQ(500u, erase_if(filtered_dq, [](int val) { return val % 2 == 0; }));
+    ASSERT_EQ(500u, filtered_dq.size());
+    for (size_t i = 0; i < filtered_dq.size(); ++i)
+        ASSERT_EQ(2 * (int)i + 1, filtered_dq[i]);
+
+    Deque<std::string> words_dq = {"keep", "drop", "keep", "drop", "drop"};
+    ASSERT_EQ(3u, erase_if(words_dq, [](const std::string& word) { return word == "drop"; }));
+    ASSERT_EQ(2u, words_dq.size());
+    ASSERT_EQ("keep", words_dq.back());
+}
+
+TEST(TestDequeElements, test_resize) {
+    Deque<int> sized_dq;
+    std::deque<int> std_sized_dq;
+    for (int step = 0; step < 500; ++step) {
+        size_t new_size = rand() % 2000;
+        int value = rand();
+        switch (rand() % 4) {
+            case 0:
+                sized_dq.resize(new_size);
+                std_sized_dq.resize(new_size);
+                break;
+            case 1:
+                sized_dq.resize(new_size, value);
+                std_sized_dq.resize(new_size, value);
+                break;
+            case 2:
+                sized_dq.resize_front(new_size);
+                if (new_size < std_sized_dq.size())
+                    std_sized_dq.erase(std_sized_dq.begin(), std_sized_dq.end() - new_size);
+                else
+                    std_sized_dq.insert(std_sized_dq.begin(), new_size - std_sized_dq.size(), 0);
+                break;
+            default:
+                sized_dq.resize_front(new_size, value);
+                if (new_size < std_sized_dq.size())
+                    std_sized_dq.erase(std_sized_dq.begin(), std_sized_dq.end() - new_size);
+                else
+                    std_sized_dq.insert(std_sized_dq.begin(), new_size - std_sized_dq.size(), value);
+                break;
+        }
+        ASSERT_EQ(std_sized_dq.size(), sized_dq.size());
+        for (size_t i = 0; i < std_sized_dq.size(); ++i)
+            ASSERT_EQ(std_sized_dq[i], sized_dq[i]);
+    }
+
+    sized_dq.resize_for_overwrite(5000);
+    ASSERT_EQ(5000u, sized_dq.size());
+    sized_dq.resize_front_for_overwrite(6000);
+    ASSERT_EQ(6000u, sized_dq.size());
+    for (int i = 0; i < 6000; ++i)
+        sized_dq[i] = i;
+    sized_dq.resize_front_for_overwrite(10);
+    ASSERT_EQ(5990, sized_dq.front());
+    sized_dq.resize_for_overwrite(5);
+    ASSERT_EQ(5994, sized_dq.back());
+
+    Deque<std::string> words_dq;
+    words_dq.push_back("word");
+    words_dq.resize(1000, words_dq.front());
+    words_dq.resize_front(2000, words_dq.back());
+    words_dq.resize_for_overwrite(3000);
+    ASSERT_EQ("word", words_dq[1999]);
+    ASSERT_EQ("", words_dq[2000]);
+    words_dq.resize_front(1500);
+    ASSERT_EQ("word", words_dq.front());
+
+    CountedElement::alive = 0;
+    {
+        Deque<CountedElement> counted_dq;
+        counted_dq.resize(1000, CountedElement(1));
+        counted_dq.resize_front(1500, CountedElement(2));
+        ASSERT_EQ(1500, CountedElement::alive);
+        counted_dq.resize(700, CountedElement(3));
+        ASSERT_EQ(700, CountedElement::alive);
+        ASSERT_EQ(2, counted_dq.front().value);
+        ASSERT_EQ(1, counted_dq.back().value);
+    }
+    ASSERT_EQ(0, CountedElement::alive);
+}
+
+template <class Elem, class MakeElem>
+void check_segments_and_linearize(MakeElem make_elem) {
+    for (int step = 0; step < 200; ++step) {
+        Deque<Elem> ring_dq;
+        std::deque<Elem> std_ring_dq;
+        for (int i = rand() % 300; i > 0; --i) {
+            Elem elem = make_elem(rand());
+            if (rand() % 2) {
+                ring_dq.push_back(elem);
+                std_ring_dq.push_back(elem);
+            } else {
+                ring_dq.push_front(elem);
+                std_ring_dq.push_front(elem);
+            }
+        }
+        DequeSegments<const Elem*> parts = static_cast<const Deque<Elem>&>(ring_dq).segments();
+        ASSERT_EQ(std_ring_dq.size(), parts.first.size + parts.second.size);
+        ASSERT_TRUE(std::equal(parts.first.begin(), parts.first.end(), std_ring_dq.begin()));
+        ASSERT_TRUE(std::equal(parts.second.begin(), parts.second.end(), std_ring_dq.begin() + parts.first.size));
+        ASSERT_TRUE(std_ring_dq.empty() || parts.first.size > 0);
+
+        Elem* data = ring_dq.linearize();
+        ASSERT_TRUE(std::equal(data, data + ring_dq.size(), std_ring_dq.begin()));
+        ASSERT_TRUE(ring_dq.segments().second.empty());
+        ASSERT_EQ(data, ring_dq.segments().first.data);
+        ASSERT_EQ(data, ring_dq.linearize());
+        for (size_t i = 0; i < std_ring_dq.size(); ++i)
+            ASSERT_EQ(std_ring_dq[i], ring_dq[i]);
+        ring_dq.push_front(make_elem(0));
+        ring_dq.push_back(make_elem(1));
+        ASSERT_EQ(std_ring_dq.size() + 2, ring_dq.size());
+    }
+}
+
+TEST(TestDequeElements, test_segments_and_linearize) {
+    check_segments_and_linearize<int>(make_int);
+    check_segments_and_linearize<std::string>(make_string);
+}
+
+TEST(TestDequeElements, test_segmented_algorithms) {
+    for (int step = 0; step < 200; ++step) {
+        Deque<int> ring_dq;
+        std::deque<int> std_ring_dq;
+        for (int i = rand() % 300; i > 0; --i) {
+            int elem = rand() % 50;
+            if (rand() % 2) {
+                ring_dq.push_back(elem);
+                std_ring_dq.push_back(elem);
+            } else {
+                ring_dq.push_front(elem);
+                std_ring_dq.push_front(elem);
+            }
+        }
+        const Deque<int>& const_dq = ring_dq;
+        int from = std_ring_dq.empty() ? 0 : rand() % (int)std_ring_dq.size();
+        int to = from + rand() % ((int)std_ring_dq.size() - from + 1);
+
+        std::vector<int> copied;
+        segmented::copy(const_dq.begin() + from, const_dq.begin() + to, std::back_inserter(copied));
+        ASSERT_TRUE(std::equal(copied.begin(), copied.end(), std_ring_dq.begin() + from));
+        ASSERT_EQ(to - from, (int)copied.size());
+        ASSERT_TRUE(segmented::equal(const_dq.begin() + from, const_dq.begin() + to, copied.begin()));
+        if (!copied.empty()) {
+            ++copied.back();
+            ASSERT_FALSE(segmented::equal(const_dq.begin() + from, const_dq.begin() + to, copied.begin()));
+        }
+
+        ASSERT_EQ(std::accumulate(std_ring_dq.begin() + from, std_ring_dq.begin() + to, 0LL),
+                  segmented::accumulate(const_dq.begin() + from, const_dq.begin() + to, 0LL));
+        ASSERT_EQ(std::accumulate(std_ring_dq.begin(), std_ring_dq.end(), 1, std::bit_xor<int>()),
+                  segmented::accumulate(const_dq.begin(), const_dq.end(), 1, std::bit_xor<int>()));
+
+        int needle = rand() % 50;
+        ASSERT_EQ(std::find(std_ring_dq.begin() + from, std_ring_dq.begin() + to, needle) - std_ring_dq.begin(),
+                  segmented::find(ring_dq.begin() + from, ring_dq.begin() + to, needle) - ring_dq.begin());
+
+        segmented::fill(ring_dq.begin() + from, ring_dq.begin() + to, -1);
+        std::fill(std_ring_dq.begin() + from, std_ring_dq.begin() + to, -1);
+        ASSERT_TRUE(segmented::equal(const_dq.begin(), const_dq.end(), std_ring_dq.begin()));
+    }
+
+    std::list<std::string> words = {"a", "b", "c"};
+    ASSERT_EQ("abc", segmented::accumulate(words.begin(), words.end(), std::string()));
+    ASSERT_EQ("b", *segmented::find(words.begin(), words.end(), "b"));
+
+    // A single-pass range is read once across both segments
+    Deque<int> wrapped_dq;
+    for (int i = 0; i < 5; ++i) {
+        wrapped_dq.push_back(i);
+        wrapped_dq.push_front(-i - 1);
+    }
+    ASSERT_NE(0u, wrapped_dq.segments().second.size);
+    std::istringstream numbers("-5 -4 -3 -2 -1 0 1 2 3 4");
+    ASSERT_TRUE(segmented::equal(wrapped_dq.begin(), wrapped_dq.end(), std::istream_iterator<int>(numbers)));
+    std::istringstream other_numbers("-5 -4 -3 -2 -1 0 1 2 3 5");
+    ASSERT_FALSE(segmented::equal(wrapped_dq.begin(), wrapped_dq.end(), std::istream_iterator<int>(other_numbers)));
+
+    // Containers without segments() have index iterators, which fall back to std
+    SegmentedDeque<int, 16> blocks_dq;
+    IncrementalDeque<int> incremental_dq;
+    for (int i = 0; i < 100; ++i) {
+        blocks_dq.push_back(i);
+        incremental_dq.push_back(i);
+    }
+    segmented::fill(blocks_dq.begin() + 90, blocks_dq.end(), 0);
+    segmented::fill(incremental_dq.begin() + 90, incremental_dq.end(), 0);
+    ASSERT_EQ(89 * 90 / 2, segmented::accumulate(blocks_dq.begin(), blocks_dq.end(), 0));
+    ASSERT_EQ(89 * 90 / 2, segmented::accumulate(incremental_dq.begin(), incremental_dq.end(), 0,
+                                                 std::plus<int>()));
+    ASSERT_EQ(42, segmented::find(blocks_dq.cbegin(), blocks_dq.cend(), 42) - blocks_dq.cbegin());
+    ASSERT_EQ(42, segmented::find(incremental_dq.begin(), incremental_dq.end(), 42) - incremental_dq.begin());
+    std::vector<int> copied;
+    segmented::copy(blocks_dq.begin(), blocks_dq.end(), std::back_inserter(copied));
+    ASSERT_TRUE(segmented::equal(incremental_dq.begin(), incremental_dq.end(), copied.begin()));
+}
+
+TEST(TestDequeElements, test_iterator_conformance) {
+    typedef Deque<int>::iterator iterator;
+    typedef Deque<int>::const_iterator const_iterator;
+    ASSERT_TRUE((std::is_same<std::iterator_traits<iterator>::iterator_category,
+                              std::random_access_iterator_tag>::value));
+    ASSERT_TRUE((std::is_same<std::iterator_traits<iterator>::difference_type, std::ptrdiff_t>::value));
+    ASSERT_TRUE((std::is_same<std::iterator_traits<const_iterator>::value_type, int>::value));
+    ASSERT_TRUE((std::is_same<std::iterator_traits<const_iterator>::reference, const int&>::value));
+    ASSERT_TRUE((std::is_convertible<iterator, const_iterator>::value));
+    ASSERT_FALSE((std::is_convertible<const_iterator, iterator>::value));
+    ASSERT_LE(sizeof(iterator), 2 * sizeof(void*));
+
+    Deque<int> ring_dq;
+    std::vector<int> sorted;
+    for (int i = 0; i < 1000; ++i) {
+        int elem = rand();
+        if (i % 2)
+            ring_dq.push_back(elem);
+        else
+            ring_dq.push_front(elem);
+        sorted.push_back(elem);
+    }
+    std::sort(ring_dq.begin(), ring_dq.end());
+    std::sort(sorted.begin(), sorted.end());
+    ASSERT_TRUE(std::equal(sorted.begin(), sorted.end(), ring_dq.cbegin()));
+    ASSERT_TRUE(std::is_sorted(ring_dq.rbegin(), ring_dq.rend(), std::greater<int>()));
+
+    iterator it = ring_dq.begin() + 10;
+    const_iterator const_it = it;
+    ASSERT_TRUE(const_it == it);
+    ASSERT_EQ(10, const_it - ring_dq.cbegin());
+    ASSERT_EQ(ring_dq[10], *const_it);
+    ASSERT_EQ(ring_dq[12], const_it[2]);
+    ASSERT_EQ(ring_dq[9], *(const_it - 1));
+    ASSERT_EQ(ring_dq[11], *(1 + it));
+    *it = -1;
+    ASSERT_EQ(-1, ring_dq[10]);
+    ASSERT_EQ(9, *iterator(&ring_dq, 5) = 9);
+    ASSERT_EQ(9, ring_dq[5]);
+
+    // Distances beyond the range of int must not overflow
+    const std::ptrdiff_t far = std::ptrdiff_t(1) << 40;
+    iterator far_it = ring_dq.begin() + far;
+    ASSERT_EQ(far, far_it - ring_dq.begin());
+    ASSERT_TRUE(ring_dq.end() < far_it);
+    far_it -= far;
+    ASSERT_TRUE(far_it == ring_dq.begin());
+
+    // iterator and const_iterator compare both ways
+    ASSERT_TRUE(it == const_it && const_it == it);
+    ASSERT_FALSE(it != const_it || const_it != it);
+    ASSERT_TRUE(ring_dq.cbegin() < it && it > ring_dq.cbegin());
+    ASSERT_TRUE(it <= const_it && const_it >= it);
+    ASSERT_EQ(10, it - ring_dq.cbegin());
+    ASSERT_EQ(-10, ring_dq.cbegin() - it);
+
+    // A dereferenced iterator points right at the element
+    ASSERT_EQ(&ring_dq[10], &*it);
+    ASSERT_EQ(&ring_dq[11], &*++it);
+
+    // In a full, wrapped ring end() differs from begin(), and iterators cross the wrap both ways
+    Deque<int> full_dq;
+    for (int i = 0; i < 16; ++i)
+        full_dq.push_back(i);
+    for (int i = 0; i < 5; ++i) {
+        full_dq.pop_front();
+        full_dq.push_back(16 + i);
+    }
+    ASSERT_EQ(16u, full_dq.capacity());
+    ASSERT_NE(0u, full_dq.segments().second.size);
+    ASSERT_TRUE(full_dq.begin() != full_dq.end());
+    ASSERT_EQ(16, full_dq.end() - full_dq.begin());
+    int expected = 5;
+    for (const_iterator full_it = full_dq.cbegin(); full_it != full_dq.cend(); ++full_it)
+        ASSERT_EQ(expected++, *full_it);
+    ASSERT_EQ(21, expected);
+    for (Deque<int>::reverse_iterator full_it = full_dq.rbegin(); full_it != full_dq.rend(); ++full_it)
+        ASSERT_EQ(--expected, *full_it);
+    ASSERT_EQ(5, expected);
+    for (std::ptrdiff_t from = -3; from <= 19; ++from) {
+        for (std::ptrdiff_t to = -3; to <= 19; ++to) {
+            iterator from_it = full_dq.begin() + from;
+            ASSERT_EQ(to, (from_it + (to - from)) - full_dq.begin());
+            ASSERT_EQ(to - from, (full_dq.begin() + to) - from_it);
+            ASSERT_EQ(from < to, from_it < full_dq.begin() + to);
+            if (from >= 0 && from < 16)
+                ASSERT_EQ(&full_dq[from], &*from_it);
+        }
+        iterator step_it = full_dq.begin() + from;
+        ++step_it;
+        ASSERT_TRUE(step_it == full_dq.begin() + (from + 1));
+        --step_it;
+        --step_it;
+        ASSERT_TRUE(step_it == full_dq.begin() + (from - 1));
+    }
+
+    IncrementalDeque<int> incremental_dq;
+    for (int i = 0; i < 1000; ++i)
+        incremental_dq.push_front(i);
+    ASSERT_EQ(1000, incremental_dq.end() - incremental_dq.begin());
+    std::sort(incremental_dq.begin(), incremental_dq.end());
+    for (int i = 0; i < 1000; ++i)
+        ASSERT_EQ(i, incremental_dq[i]);
+    ASSERT_EQ(999, *incremental_dq.rbegin());
+}
+
+#if __cplusplus >= 202002L
+constexpr int static_deque_constant() {
+    StaticDeque<int, 4, DEQUE_OVERFLOW_OVERWRITE> ring_dq;
+    for (int i = 1; i <= 6; ++i)
+        ring_dq.push_back(i);
+    ring_dq.push_front(0);
+    int sum = 0;
+    for (int elem : ring_dq)
+        sum = sum * 10 + elem;
+    return sum;
+}
+
+static_assert(static_deque_constant() == 345, "StaticDeque must be usable in constant expressions");
+#endif
+
+TEST(TestDequeElements, test_static_deque) {
+    StaticDeque<int, 8> ring_dq;
+    std::deque<int> std_ring_dq;
+    ASSERT_GE(sizeof(ring_dq), 8 * sizeof(int));
+    ASSERT_EQ(8, ring_dq.capacity());
+    for (int step = 0; step < 10000; ++step) {
+        int elem = rand();
+        int action = rand() % 4;
+        if (action == 0 && !ring_dq.full()) {
+            ASSERT_TRUE(ring_dq.push_back(elem));
+            std_ring_dq.push_back(elem);
+        } else if (action == 1 && !ring_dq.full()) {
+            ASSERT_TRUE(ring_dq.push_front(elem));
+            std_ring_dq.push_front(elem);
+        } else if (action == 2 && !ring_dq.empty()) {
+            ring_dq.pop_back();
+            std_ring_dq.pop_back();
+        } else if (action == 3 && !ring_dq.empty()) {
+            ring_dq.pop_front();
+            std_ring_dq.pop_front();
+        }
+        ASSERT_EQ(std_ring_dq.size(), ring_dq.size());
+        ASSERT_TRUE(std::equal(ring_dq.begin(), ring_dq.end(), std_ring_dq.begin()));
+    }
+    ring_dq.clear();
+    while (!ring_dq.full())
+        ring_dq.push_back(1);
+    ASSERT_EQ(8, ring_dq.size());
+    ASSERT_THROW(ring_dq.push_back(2), std::length_error);
+    ASSERT_THROW(ring_dq.push_front(2), std::length_error);
+    ASSERT_EQ(8, ring_dq.size());
+    ASSERT_EQ(1, ring_dq.back());
+    ASSERT_THROW(ring_dq.at(8), std::out_of_range);
+    ASSERT_EQ(8 * 1LL, segmented::accumulate(ring_dq.cbegin(), ring_dq.cend(), 0LL));
+
+    StaticDeque<int, 4, DEQUE_OVERFLOW_FAIL> failing_dq = {1, 2, 3, 4};
+    ASSERT_FALSE(failing_dq.push_back(5));
+    ASSERT_FALSE(failing_dq.emplace_front(0));
+    ASSERT_EQ(1, failing_dq.front());
+    ASSERT_EQ(4, failing_dq.back());
+
+    StaticDeque<std::string, 4, DEQUE_OVERFLOW_OVERWRITE> words_dq = {"a", "b", "c", "d"};
+    ASSERT_FALSE(words_dq.push_back(words_dq.front()));
+    ASSERT_EQ("b", words_dq.front());
+    ASSERT_EQ("a", words_dq.back());
+    ASSERT_FALSE(words_dq.push_front("z"));
+    ASSERT_EQ("z", words_dq.front());
+    ASSERT_EQ("d", words_dq.back());
+    ASSERT_EQ(4, words_dq.size());
+    StaticDeque<std::string, 4, DEQUE_OVERFLOW_OVERWRITE> words_copy(words_dq);
+    ASSERT_TRUE(std::equal(words_dq.begin(), words_dq.end(), words_copy.begin()));
+    StaticDeque<std::string, 4, DEQUE_OVERFLOW_OVERWRITE> words_moved(std::move(words_copy));
+    ASSERT_TRUE(words_copy.empty());
+    ASSERT_EQ("z", words_moved.front());
+
+    CountedElement::alive = 0;
+    {
+        StaticDeque<CountedElement, 16, DEQUE_OVERFLOW_OVERWRITE> counted_dq;
+        for (int i = 0; i < 100; ++i)
+            counted_dq.emplace_back(i);
+        ASSERT_EQ(16, CountedElement::alive);
+        ASSERT_EQ(84, counted_dq.front().value);
+        counted_dq.pop_front();
+        ASSERT_EQ(15, CountedElement::alive);
+    }
+    ASSERT_EQ(0, CountedElement::alive);
+}
+
+TEST(TestDequeElements, test_small_deque) {
+    SmallDeque<int, 8> small_dq;
+    std::deque<int> std_small_dq;
+    for (int step = 0; step < 20000; ++step) {
+        int elem = rand();
+        // Drift between a few elements and a few hundred, crossing the inline capacity many times
+        int action = rand() % 4;
+        if (step % 4000 >= 2000)
+            action |= 1;
+        if (action == 0) {
+            small_dq.push_back(elem);
+            std_small_dq.push_back(elem);
+        } else if (action == 2) {
+            small_dq.push_front(elem);
+            std_small_dq.push_front(elem);
+        } else if (action == 1 && !small_dq.empty()) {
+            small_dq.pop_back();
+            std_small_dq.pop_back();
+        } else if (action == 3 && !small_dq.empty()) {
+            small_dq.pop_front();
+            std_small_dq.pop_front();
+        }
+        ASSERT_EQ(std_small_dq.size(), small_dq.size());
+        ASSERT_TRUE(std::equal(small_dq.begin(), small_dq.end(), std_small_dq.begin()));
+        ASSERT_TRUE(small_dq.size() > 8 || small_dq.capacity() > 8 || small_dq.is_inline());
+    }
+
+    SmallDeque<std::string, 4> words_dq = {"a", "b", "c", "d"};
+    ASSERT_TRUE(words_dq.is_inline());
+    words_dq.push_back(words_dq.front());
+    ASSERT_FALSE(words_dq.is_inline());
+    words_dq.push_front(words_dq.back());
+    ASSERT_EQ("a", words_dq.front());
+    ASSERT_EQ("a", words_dq.back());
+    ASSERT_EQ(6, words_dq.size());
+
+    SmallDeque<std::string, 4> words_copy(words_dq);
+    ASSERT_TRUE(std::equal(words_dq.begin(), words_dq.end(), words_copy.begin()));
+    SmallDeque<std::string, 4> words_moved(std::move(words_copy));
+    ASSERT_TRUE(words_copy.empty());
+    ASSERT_TRUE(words_copy.is_inline());
+    ASSERT_EQ(6, words_moved.size());
+    while (words_moved.size() > 2)
+        words_moved.pop_back();
+    words_moved.shrink_to_fit();
+    ASSERT_TRUE(words_moved.is_inline());
+    ASSERT_EQ("a", words_moved.back());
+    words_copy = words_moved;
+    SmallDeque<std::string, 4> inline_moved(std::move(words_moved));
+    ASSERT_TRUE(inline_moved.is_inline());
+    ASSERT_EQ("a", inline_moved.front());
+    ASSERT_EQ("a", words_copy.back());
+    ASSERT_THROW(inline_moved.at(2), std::out_of_range);
+
+    CountedElement::alive = 0;
+    {
+        SmallDeque<CountedElement, 4> counted_dq;
+        for (int i = 0; i < 100; ++i)
+            counted_dq.emplace_front(i);
+        ASSERT_EQ(100, CountedElement::alive);
+        while (counted_dq.size() > 1)
+            counted_dq.pop_front();
+        ASSERT_TRUE(counted_dq.is_inline());
+        ASSERT_EQ(0, counted_dq.front().value);
+        ASSERT_EQ(1, CountedElement::alive);
+        counted_dq.reserve(64);
+        ASSERT_FALSE(counted_dq.is_inline());
+        ASSERT_EQ(64, counted_dq.capacity());
+    }
+    ASSERT_EQ(0, CountedElement::alive);
+}
+
+TEST(TestDequeElements, test_full_ring_capacity) {
+    Deque<int> full_dq;
+    full_dq.reserve(16);
+    ASSERT_EQ(16, full_dq.capacity());
+    for (int i = 0; i < 16; ++i)
+        i % 2 ? full_dq.push_back(i) : full_dq.push_front(i);
+    ASSERT_EQ(16, full_dq.capacity());
+    ASSERT_EQ(14, full_dq.front());
+    ASSERT_EQ(15, full_dq.back());
+    DequeSegments<int*> parts = full_dq.segments();
+    ASSERT_EQ(16, parts.first.size + parts.second.size);
+    full_dq.push_back(16);
+    ASSERT_EQ(32, full_dq.capacity());
+    ASSERT_EQ(16, full_dq.back());
+}
+
+// Fills a ring of capacity 16 exactly, wrapped, so that its tail is back at slot 0
+template <class T>
+Deque<T> make_full_wrapped_ring(std::function<T(int)> make) {
+    Deque<T> dq;
+    dq.reserve(16);
+    for (int i = 0; i < 16; ++i)
+        i % 2 ? dq.push_back(make(i)) : dq.push_front(make(i));
+    return dq;
+}
+
+// Pops the front and pushes a new back, then checks every element against a reference
+template <class T>
+void check_pop_push_after_relocation(Deque<T>& dq, std::function<T(int)> make) {
+    std::deque<T> expected(dq.begin(), dq.end());
+    dq.pop_front();
+    expected.pop_front();
+    dq.push_back(make(100));
+    expected.push_back(make(100));
+    ASSERT_EQ(expected.size(), dq.size());
+    for (size_t i = 0; i < expected.size(); ++i)
+        ASSERT_EQ(expected[i], dq[i]);
+}
+
+template <class T>
+void check_full_ring_relocations(std::function<T(int)> make) {
+    Deque<T> original = make_full_wrapped_ring<T>(make);
+    ASSERT_EQ(16, original.capacity());
+    Deque<T> copy(original);
+    ASSERT_EQ(16, copy.capacity());
+    check_pop_push_after_relocation(copy, make);
+
+    Deque<T> shrunk;
+    shrunk.reserve(64);
+    for (int i = 0; i < 16; ++i)
+        shrunk.push_back(make(i));
+    shrunk.shrink_to_fit();
+    ASSERT_EQ(16, shrunk.capacity());
+    check_pop_push_after_relocation(shrunk, make);
+
+    Deque<T> linear = make_full_wrapped_ring<T>(make);
+    linear.linearize();
+    ASSERT_EQ(16, linear.capacity());
+    check_pop_push_after_relocation(linear, make);
+}
+
+TEST(TestDequeElements, test_full_ring_relocation) {
+    check_full_ring_relocations<int>([](int i) { return i; });
+    check_full_ring_relocations<std::string>([](int i) { return std::to_string(i); });
+}
+
+TEST(TestDequeElements, test_bounded_deque) {
+    const size_t CAPACITIES[] = {1, 5, 8, 100};
+    for (size_t capacity : CAPACITIES) {
+        BoundedDeque<int> bounded_dq(capacity);
+        std::deque<int> std_bounded_dq;
+        for (int step = 0; step < 5000; ++step) {
+            int elem = rand();
+            int action = rand() % 5;
+            bool was_full = std_bounded_dq.size() == capacity;
+            if (action < 2) {
+                if (was_full)
+                    std_bounded_dq.pop_front();
+                std_bounded_dq.push_back(elem);
+                ASSERT_EQ(!was_full, bounded_dq.push_back(elem));
+            } else if (action < 4) {
+                if (was_full)
+                    std_bounded_dq.pop_back();
+                std_bounded_dq.push_front(elem);
+                ASSERT_EQ(!was_full, bounded_dq.push_front(elem));
+            } else if (!std_bounded_dq.empty()) {
+                std_bounded_dq.pop_front();
+                bounded_dq.pop_front();
+            }
+            ASSERT_EQ(std_bounded_dq.size(), bounded_dq.size());
+            ASSERT_TRUE(std::equal(bounded_dq.begin(), bounded_dq.end(), std_bounded_dq.begin()));
+        }
+        ASSERT_EQ(capacity, bounded_dq.capacity());
+    }
+
+    BoundedDeque<std::string> words_dq(3);
+    words_dq.push_back("a");
+    words_dq.push_back("b");
+    words_dq.push_back("c");
+    ASSERT_FALSE(words_dq.push_back(words_dq.front()));
+    ASSERT_EQ("b", words_dq.front());
+    ASSERT_EQ("a", words_dq.back());
+    ASSERT_FALSE(words_dq.push_front(words_dq.back()));
+    ASSERT_EQ("a", words_dq.front());
+    ASSERT_EQ("c", words_dq.back());
+    BoundedDeque<std::string> words_copy(words_dq);
+    words_copy.push_back("d");
+    ASSERT_EQ("b", words_copy.front());
+    ASSERT_EQ("a", words_dq.front());
+    words_dq = words_copy;
+    ASSERT_EQ("d", words_dq.back());
+    ASSERT_THROW(words_dq.at(3), std::out_of_range);
+    ASSERT_THROW(BoundedDeque<int>(0), std::invalid_argument);
+
+    CountedElement::alive = 0;
+    {
+        BoundedDeque<CountedElement> counted_dq(10);
+        for (int i = 0; i < 100; ++i)
+            counted_dq.emplace_back(i);
+        ASSERT_EQ(10, CountedElement::alive);
+        ASSERT_EQ(90, counted_dq.front().value);
+        BoundedDeque<CountedElement> counted_moved(std::move(counted_dq));
+        ASSERT_EQ(10, CountedElement::alive);
+        ASSERT_EQ(99, counted_moved.back().value);
+        // The moved-from ring stays usable and keeps nothing
+        ASSERT_FALSE(counted_dq.push_back(CountedElement(1)));
+        ASSERT_FALSE(counted_dq.emplace_front(2));
+        ASSERT_TRUE(counted_dq.empty());
+        ASSERT_EQ(10, CountedElement::alive);
+        counted_dq = counted_moved;
+        ASSERT_FALSE(counted_dq.push_back(CountedElement(100)));
+        ASSERT_EQ(91, counted_dq.front().value);
+    }
+    ASSERT_EQ(0, CountedElement::alive);
+}
+
+TEST(TestDequeElements, test_segmented_deque) {
+    SegmentedDeque<int, 64> blocks_dq;
+    std::deque<int> std_blocks_dq;
+    ASSERT_EQ(16, blocks_dq.block_size());
+    std::vector<ActionType> actions;
+    generate_actions(actions, 100000);
+    for (size_t i = 0; i < actions.size(); ++i) {
+        int val = rand();
+        if (actions[i] == PUSH_BACK) {
+            blocks_dq.push_back(val);
+            std_blocks_dq.push_back(val);
+        } else if (actions[i] == PUSH_FRONT) {
+            blocks_dq.push_front(val);
+            std_blocks_dq.push_front(val);
+        } else if (actions[i] == POP_BACK) {
+            blocks_dq.pop_back();
+            std_blocks_dq.pop_back();
+        } else {
+            blocks_dq.pop_front();
+            std_blocks_dq.pop_front();
+        }
+        ASSERT_EQ(std_blocks_dq.size(), blocks_dq.size());
+        if (!std_blocks_dq.empty()) {
+            ASSERT_EQ(std_blocks_dq.front(), blocks_dq.front());
+            ASSERT_EQ(std_blocks_dq.back(), blocks_dq.back());
+        }
+    }
+    ASSERT_TRUE(std::equal(blocks_dq.begin(), blocks_dq.end(), std_blocks_dq.begin()));
+    ASSERT_TRUE(std::equal(blocks_dq.rbegin(), blocks_dq.rend(), std_blocks_dq.rbegin()));
+
+    // References survive pushes and pops of other elements at both ends
+    SegmentedDeque<std::string, 128> words_dq = {"stable"};
+    std::string* stable = &words_dq.front();
+    for (int i = 0; i < 1000; ++i) {
+        words_dq.push_back(words_dq.front());
+        words_dq.push_front(*stable + "!");
+    }
+    for (int i = 0; i < 500; ++i) {
+        words_dq.pop_front();
+        words_dq.pop_back();
+    }
+    ASSERT_EQ(stable, &words_dq[500]);
+    ASSERT_EQ("stable", *stable);
+    ASSERT_EQ("stable!", words_dq.front());
+    SegmentedDeque<std::string, 128> words_copy(words_dq);
+    ASSERT_TRUE(std::equal(words_dq.begin(), words_dq.end(), words_copy.begin()));
+    SegmentedDeque<std::string, 128> words_moved(std::move(words_copy));
+    ASSERT_TRUE(words_copy.empty());
+    ASSERT_EQ(stable, &words_dq[500]);
+    words_copy = words_moved;
+    ASSERT_EQ(1001, words_copy.size());
+    ASSERT_THROW(words_copy.at(1001), std::out_of_range);
+
+    CountedElement::alive = 0;
+    {
+        SegmentedDeque<CountedElement, 256> counted_dq;
+        for (int i = 0; i < 1000; ++i)
+            i % 2 ? counted_dq.emplace_back(i) : counted_dq.emplace_front(i);
+        ASSERT_EQ(1000, CountedElement::alive);
+        for (int i = 0; i < 300; ++i)
+            counted_dq.pop_front();
+        ASSERT_EQ(700, CountedElement::alive);
+        counted_dq.clear();
+        ASSERT_EQ(0, CountedElement::alive);
+        counted_dq.emplace_front(1);
+    }
+    ASSERT_EQ(0, CountedElement::alive);
+}
+
+#ifdef DEQUE_HAS_MIRRORED_DEQUE
+TEST(TestDequeElements, test_mirrored_deque) {
+    MirroredDeque<int> mirrored_dq;
+    std::deque<int> std_mirrored_dq;
+    size_t initial_capacity = mirrored_dq.capacity();
+    ASSERT_EQ(0u, initial_capacity * sizeof(int) % sysconf(_SC_PAGESIZE));
+    std::vector<ActionType> actions;
+    generate_actions(actions, 100000);
+    for (size_t i = 0; i < actions.size(); ++i) {
+        int val = rand();
+        if (actions[i] == PUSH_BACK) {
+            mirrored_dq.push_back(val);
+            std_mirrored_dq.push_back(val);
+        } else if (actions[i] == PUSH_FRONT) {
+            mirrored_dq.push_front(val);
+            std_mirrored_dq.push_front(val);
+        } else if (actions[i] == POP_BACK) {
+            mirrored_dq.pop_back();
+            std_mirrored_dq.pop_back();
+        } else {
+            mirrored_dq.pop_front();
+            std_mirrored_dq.pop_front();
+        }
+    }
+    ASSERT_EQ(std_mirrored_dq.size(), mirrored_dq.size());
+    ASSERT_TRUE(std::equal(mirrored_dq.data(), mirrored_dq.data() + mirrored_dq.size(), std_mirrored_dq.begin()));
+
+    // Elements that wrap around the end of the ring are still one array
+    MirroredDeque<int> wrapped_dq;
+    size_t capacity = wrapped_dq.capacity();
+    for (size_t i = 0; i < capacity; ++i)
+        wrapped_dq.push_back(-1);
+    for (size_t i = 0; i < capacity / 2; ++i) {
+        wrapped_dq.pop_front();
+        wrapped_dq.push_back(i);
+    }
+    ASSERT_EQ(capacity, wrapped_dq.capacity());
+    ASSERT_EQ(capacity, wrapped_dq.size());
+    const int* data = wrapped_dq.data();
+    ASSERT_EQ(-1, data[capacity / 2 - 1]);
+    ASSERT_EQ(0, data[capacity - capacity / 2]);
+    ASSERT_EQ((int)(capacity / 2 - 1), data[capacity - 1]);
+    ASSERT_TRUE(wrapped_dq.segments().second.empty());
+    ASSERT_EQ(wrapped_dq.data(), &*wrapped_dq.begin());
+    ASSERT_EQ(wrapped_dq.back(), *wrapped_dq.rbegin());
+    wrapped_dq.push_back(wrapped_dq.front());
+    ASSERT_EQ(-1, wrapped_dq.back());
+    ASSERT_LT(capacity, wrapped_dq.capacity());
+
+    // Bulk transfers, including a source inside the deque itself
+    std::vector<int> values(5000);
+    for (int i = 0; i < 5000; ++i)
+        values[i] = i;
+    MirroredDeque<int> bulk_dq;
+    bulk_dq.append(values.data(), values.data() + 5000);
+    bulk_dq.append(bulk_dq.data(), bulk_dq.data() + 5000);
+    ASSERT_EQ(10000, bulk_dq.size());
+    ASSERT_EQ(4999, bulk_dq[9999]);
+    std::vector<int> popped(3000);
+    ASSERT_EQ(popped.data() + 3000, bulk_dq.pop_front_n(3000, popped.data()));
+    ASSERT_TRUE(std::equal(popped.begin(), popped.end(), values.begin()));
+    ASSERT_EQ(3000, bulk_dq.front());
+
+    int fds[2];
+    ASSERT_EQ(0, pipe(fds));
+    ASSERT_EQ((ssize_t)(100 * sizeof(int)), write(fds[1], values.data(), 100 * sizeof(int)));
+    ssize_t bytes = read(fds[0], bulk_dq.prepare_back(100), 100 * sizeof(int));
+    ASSERT_EQ((ssize_t)(100 * sizeof(int)), bytes);
+    bulk_dq.commit_back(bytes / sizeof(int));
+    close(fds[0]);
+    close(fds[1]);
+    ASSERT_EQ(7100, bulk_dq.size());
+    ASSERT_EQ(99, bulk_dq.back());
+
+    MirroredDeque<int> copied_dq(bulk_dq);
+    ASSERT_TRUE(std::equal(copied_dq.begin(), copied_dq.end(), bulk_dq.begin()));
+    MirroredDeque<int> moved_dq(std::move(copied_dq));
+    ASSERT_TRUE(copied_dq.empty());
+    copied_dq.push_front(7);
+    ASSERT_EQ(7, copied_dq.front());
+    moved_dq.shrink_to_fit();
+    ASSERT_EQ(7100, moved_dq.size());
+    ASSERT_THROW(moved_dq.at(7100), std::out_of_range);
+}
+#endif
+
+TEST(TestDequeElements, test_spsc_deque) {
+    SpscDeque<int> spsc_dq(5);
+    ASSERT_EQ(8, spsc_dq.capacity());
+    int popped = 0;
+    ASSERT_FALSE(spsc_dq.try_pop(popped));
+    for (int i = 0; i < 8; ++i)
+        ASSERT_TRUE(spsc_dq.try_push(i));
+    ASSERT_FALSE(spsc_dq.try_push(8));
+    ASSERT_EQ(8, spsc_dq.size_approx());
+    ASSERT_TRUE(spsc_dq.try_pop(popped));
+    ASSERT_EQ(0, popped);
+    std::vector<int> values = {8, 9, 10};
+    ASSERT_EQ(1, spsc_dq.try_push_n(values.begin(), values.size()));
+    std::vector<int> batch;
+    ASSERT_EQ(8, spsc_dq.try_pop_n(std::back_inserter(batch), 100));
+    for (int i = 0; i < 8; ++i)
+        ASSERT_EQ(i + 1, batch[i]);
+    ASSERT_TRUE(spsc_dq.empty_approx());
+    ASSERT_THROW(SpscDeque<int>(0), std::invalid_argument);
+
+    CountedElement::alive = 0;
+    {
+        SpscDeque<CountedElement> counted_dq(16);
+        for (int i = 0; i < 10; ++i)
+            counted_dq.try_emplace(i);
+        CountedElement out(-1);
+        counted_dq.try_pop(out);
+        ASSERT_EQ(0, out.value);
+        ASSERT_EQ(10, CountedElement::alive);
+    }
+    ASSERT_EQ(0, CountedElement::alive);
+
+    // Both sides running at once, in single and batched mode
+    const int COUNT = 1 << 18;
+    SpscDeque<std::string> words_dq(64);
+    std::thread producer([&words_dq]() {
+        for (int i = 0; i < COUNT; ++i) {
+            if (i % 1000 == 0) {
+                std::vector<std::string> chunk(100, std::to_string(i));
+                size_t pushed = 0;
+                while (pushed < chunk.size()) {
+                    pushed += words_dq.try_push_n(chunk.begin() + pushed, chunk.size() - pushed);
+                    std::this_thread::yield();
+                }
+            }
+            while (!words_dq.try_push(std::to_string(i)))
+                std::this_thread::yield();
+        }
+    });
+    long long received = 0;
+    int expected = 0;
+    std::vector<std::string> chunk(32);
+    while (expected < COUNT) {
+        size_t count = words_dq.try_pop_n(chunk.begin(), chunk.size());
+        if (count == 0)
+            std::this_thread::yield();
+        for (size_t i = 0; i < count; ++i) {
+            ++received;
+            if (chunk[i] == std::to_string(expected))
+                ++expected;
+        }
+    }
+    producer.join();
+    ASSERT_EQ(COUNT + (long long)(COUNT + 999) / 1000 * 100, received);
+    ASSERT_TRUE(words_dq.empty_approx());
+}
+
+TEST(TestDequeElements, test_mpmc_deque) {
+    MpmcDeque<int> mpmc_dq(6);
+    ASSERT_EQ(8, mpmc_dq.capacity());
+    int popped = 0;
+    ASSERT_FALSE(mpmc_dq.try_pop(popped));
+    for (int i = 0; i < 8; ++i)
+        ASSERT_TRUE(mpmc_dq.try_push(i));
+    ASSERT_FALSE(mpmc_dq.try_push(8));
+    ASSERT_TRUE(mpmc_dq.try_pop(popped));
+    ASSERT_EQ(0, popped);
+    std::vector<int> values = {8, 9, 10};
+    ASSERT_EQ(1, mpmc_dq.try_push_n(values.begin(), values.size()));
+    ASSERT_EQ(0, mpmc_dq.try_push_n(values.begin(), values.size()));
+    std::vector<int> batch;
+    ASSERT_EQ(5, mpmc_dq.try_pop_n(std::back_inserter(batch), 5));
+    ASSERT_EQ(3, mpmc_dq.try_pop_n(std::back_inserter(batch), 100));
+    for (int i = 0; i < 8; ++i)
+        ASSERT_EQ(i + 1, batch[i]);
+    ASSERT_EQ(0, mpmc_dq.size_approx());
+    ASSERT_THROW(MpmcDeque<int>(0), std::invalid_argument);
+
+    MpmcDeque<std::string> words_dq(4);
+    std::vector<std::string> words = {"a", "b", "c"};
+    ASSERT_EQ(3, words_dq.try_push_n(words.begin(), words.size()));
+    ASSERT_TRUE(words_dq.try_emplace(2, 'd'));
+    ASSERT_FALSE(words_dq.try_push("e"));
+    std::string word;
+    ASSERT_TRUE(words_dq.try_pop(word));
+    ASSERT_EQ("a", word);
+
+    // Several producers and consumers at once, every element must arrive exactly once
+    const int PRODUCERS = 4;
+    const int CONSUMERS = 3;
+    const int COUNT = 1 << 16;
+    MpmcDeque<int> shared_dq(64);
+    std::vector<std::thread> threads;
+    std::vector<std::vector<int>> received(CONSUMERS);
+    std::atomic<int> consumed(0);
+    for (int p = 0; p < PRODUCERS; ++p) {
+        threads.push_back(std::thread([&shared_dq, p]() {
+            std::vector<int> chunk(8);
+            for (int i = p; i < COUNT; i += PRODUCERS * 8) {
+                size_t count = 0;
+                for (int j = i; j < COUNT && count < chunk.size(); j += PRODUCERS)
+                    chunk[count++] = j;
+                for (size_t pushed = 0; pushed < count;) {
+                    pushed += shared_dq.try_push_n(chunk.begin() + pushed, count - pushed);
+                    std::this_thread::yield();
+                }
+            }
+        }));
+    }
+    for (int c = 0; c < CONSUMERS; ++c) {
+        threads.push_back(std::thread([&shared_dq, &received, &consumed, c]() {
+            int value;
+            while (consumed.load() < COUNT) {
+                size_t count = 0;
+                if (c % 2 == 0 && shared_dq.try_pop(value)) {
+                    received[c].push_back(value);
+                    count = 1;
+                } else if (c % 2 == 1) {
+                    count = shared_dq.try_pop_n(std::back_inserter(received[c]), 5);
+                }
+                if (count == 0)
+                    std::this_thread::yield();
+                consumed += count;
+            }
+        }));
+    }
+    for (size_t i = 0; i < threads.size(); ++i)
+        threads[i].join();
+    std::vector<int> all;
+    for (int c = 0; c < CONSUMERS; ++c)
+        all.insert(all.end(), received[c].begin(), received[c].end());
+    std::sort(all.begin(), all.end());
+    ASSERT_EQ(COUNT, all.size());
+    for (int i = 0; i < COUNT; ++i)
+        ASSERT_EQ(i, all[i]);
+}
+
+TEST(TestDequeElements, test_work_stealing_deque) {
+    WorkStealingDeque<int> ws_dq(2);
+    int taken = 0;
+    ASSERT_FALSE(ws_dq.try_pop_back(taken));
+    ASSERT_FALSE(ws_dq.try_steal_front(taken));
+    // The owner pops the newest element, thieves take the oldest, the ring grows as needed
+    for (int i = 0; i < 100; ++i)
+        ws_dq.push_back(i);
+    ASSERT_EQ(100, ws_dq.size_approx());
+    ASSERT_TRUE(ws_dq.try_pop_back(taken));
+    ASSERT_EQ(99, taken);
+    ASSERT_TRUE(ws_dq.try_steal_front(taken));
+    ASSERT_EQ(0, taken);
+    for (int i = 98; i >= 1; --i) {
+        ASSERT_TRUE(ws_dq.try_pop_back(taken));
+        ASSERT_EQ(i, taken);
+    }
+    ASSERT_FALSE(ws_dq.try_pop_back(taken));
+    ASSERT_FALSE(ws_dq.try_steal_front(taken));
+    ASSERT_EQ(1, taken);
+    ASSERT_EQ(0, ws_dq.size_approx());
+    ASSERT_THROW(WorkStealingDeque<int>(0), std::invalid_argument);
+
+    // The owner pushes and pops while thieves steal, every element must be taken exactly once
+    const int THIEVES = 3;
+    const int COUNT = 1 << 16;
+    WorkStealingDeque<int> shared_dq(4);
+    std::vector<std::vector<int>> received(THIEVES + 1);
+    std::atomic<int> consumed(0);
+    std::vector<std::thread> thieves;
+    for (int t = 0; t < THIEVES; ++t) {
+        thieves.push_back(std::thread([&shared_dq, &received, &consumed, t]() {
+            int value;
+            while (consumed.load() < COUNT) {
+                if (shared_dq.try_steal_front(value)) {
+                    received[t].push_back(value);
+                    ++consumed;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        }));
+    }
+    int value;
+    for (int i = 0; i < COUNT; ++i) {
+        shared_dq.push_back(i);
+        if (i % 3 == 0 && shared_dq.try_pop_back(value)) {
+            received[THIEVES].push_back(value);
+            ++consumed;
+        }
+    }
+    while (shared_dq.try_pop_back(value)) {
+        received[THIEVES].push_back(value);
+        ++consumed;
+    }
+    for (size_t i = 0; i < thieves.size(); ++i)
+        thieves[i].join();
+    std::vector<int> all;
+    for (size_t t = 0; t < received.size(); ++t)
+        all.insert(all.end(), received[t].begin(), received[t].end());
+    std::sort(all.begin(), all.end());
+    ASSERT_EQ(COUNT, all.size());
+    for (int i = 0; i < COUNT; ++i)
+        ASSERT_EQ(i, all[i]);
+}
+
+long long serial_fib(int n) {
+    return n < 2 ? n : serial_fib(n - 1) + serial_fib(n - 2);
+}
+
+long long parallel_fib(ForkJoinPool& pool, int n, int cutoff) {
+    if (n <= cutoff)
+        return serial_fib(n);
+    long long first = 0;
+    ForkJoinPool::TaskGroup group(pool);
+    group.spawn([&pool, &first, n, cutoff]() {
+        first = parallel_fib(pool, n - 1, cutoff);
+    });
+    long long second = parallel_fib(pool, n - 2, cutoff);
+    group.wait();
+    return first + second;
+}
+
+// Three-way partition, then the two sides are sorted in parallel
+void parallel_quicksort(ForkJoinPool& pool, Deque<int>::iterator first, Deque<int>::iterator last, ptrdiff_t cutoff) {
+    if (last - first <= cutoff) {
+        std::sort(first, last);
+        return;
+    }
+    int pivot = *(first + (last - first) / 2);
+    Deque<int>::iterator less_end = std::partition(first, last, [pivot](int x) { return x < pivot; });
+    Deque<int>::iterator equal_end = std::partition(less_end, last, [pivot](int x) { return !(pivot < x); });
+    ForkJoinPool::TaskGroup group(pool);
+    group.spawn([&pool, first, less_end, cutoff]() {
+        parallel_quicksort(pool, first, less_end, cutoff);
+    });
+    parallel_quicksort(pool, equal_end, last, cutoff);
+    group.wait();
+}
+
+TEST(TestDequeElements, test_fork_join_pool) {
+    ForkJoinScheduling schedulings[] = {FORK_JOIN_WORK_STEALING, FORK_JOIN_GLOBAL_QUEUE};
+    for (ForkJoinScheduling scheduling : schedulings) {
+        ForkJoinPool pool(3, scheduling);
+        ASSERT_EQ(3, pool.size());
+        long long fib = 0;
+        pool.run([&pool, &fib]() {
+            fib = parallel_fib(pool, 20, 5);
+        });
+        ASSERT_EQ(6765, fib);
+
+        Deque<int> dq;
+        for (int i = 0; i < 10000; ++i)
+            dq.push_back((i * 7919) % 1000);
+        pool.run([&pool, &dq]() {
+            parallel_quicksort(pool, dq.begin(), dq.end(), 64);
+        });
+        ASSERT_TRUE(std::is_sorted(dq.begin(), dq.end()));
+        ASSERT_EQ(10000, dq.size());
+
+        // Tasks spawned from outside the pool
+        std::atomic<int> counter(0);
+        {
+            ForkJoinPool::TaskGroup group(pool);
+            for (int i = 0; i < 100; ++i)
+                group.spawn([&counter]() { ++counter; });
+        }
+        ASSERT_EQ(100, counter.load());
+    }
+}
+
+TEST(TestDequeElements, test_concurrent_deque) {
+    ConcurrentDeque<int> cdq(4);
+    ASSERT_EQ(4, cdq.capacity());
+    int popped = 0;
+    ASSERT_FALSE(cdq.try_pop(popped));
+    ASSERT_FALSE(cdq.wait_pop_for(popped, std::chrono::milliseconds(1)));
+    for (int i = 0; i < 4; ++i)
+        ASSERT_TRUE(cdq.try_push(i));
+    ASSERT_FALSE(cdq.try_push(4));
+    ASSERT_TRUE(cdq.try_pop(popped));
+    ASSERT_EQ(0, popped);
+    ASSERT_TRUE(cdq.push(4));
+    Deque<int> batch;
+    ASSERT_EQ(2, cdq.pop_batch(2, batch));
+    ASSERT_EQ(2, cdq.pop_batch(100, batch));
+    ASSERT_EQ(4, batch.size());
+    for (int i = 0; i < 4; ++i)
+        ASSERT_EQ(i + 1, batch[i]);
+    ASSERT_TRUE(cdq.empty());
+    ASSERT_THROW(ConcurrentDeque<int>(0), std::invalid_argument);
+    ASSERT_THROW(cdq.pop_batch(0, batch), std::invalid_argument);
+
+    // A batch larger than the capacity waits for room, close() wakes blocked threads
+    std::vector<int> values(100);
+    std::iota(values.begin(), values.end(), 0);
+    std::thread producer([&cdq, &values]() {
+        ASSERT_EQ(100, cdq.push_batch(values.begin(), values.end()));
+        ASSERT_TRUE(cdq.push(100));
+    });
+    std::vector<int> received;
+    while (received.size() < 101) {
+        batch.clear();
+        cdq.pop_batch(3, batch);
+        received.insert(received.end(), batch.begin(), batch.end());
+    }
+    producer.join();
+    for (int i = 0; i <= 100; ++i)
+        ASSERT_EQ(i, received[i]);
+    std::thread consumer([&cdq]() {
+        int value;
+        ASSERT_FALSE(cdq.pop(value));
+    });
+    cdq.close();
+    consumer.join();
+    ASSERT_TRUE(cdq.is_closed());
+    ASSERT_FALSE(cdq.push(1));
+
+    // Elements pushed before close() are still popped
+    ConcurrentDeque<std::string> words;
+    ASSERT_TRUE(words.push("a"));
+    words.close();
+    std::string word;
+    ASSERT_TRUE(words.pop(word));
+    ASSERT_EQ("a", word);
+    ASSERT_FALSE(words.pop(word));
+    Deque<std::string> word_batch;
+    ASSERT_EQ(0, words.pop_batch(10, word_batch));
+
+    // Several producers and consumers through a bounded deque, every element must arrive exactly once
+    const int PRODUCERS = 3;
+    const int CONSUMERS = 3;
+    const int COUNT = 1 << 15;
+    ConcurrentDeque<int> shared(64);
+    std::vector<std::thread> producers;
+    std::vector<std::thread> consumers;
+    std::vector<std::vector<int>> results(CONSUMERS);
+    for (int p = 0; p < PRODUCERS; ++p) {
+        producers.push_back(std::thread([&shared, p]() {
+            std::vector<int> chunk;
+            for (int i = p; i < COUNT; i += PRODUCERS) {
+                if (p == 0) {
+                    shared.push(i);
+                    continue;
+                }
+                chunk.push_back(i);
+                if (chunk.size() == 10) {
+                    shared.push_batch(chunk.begin(), chunk.end());
+                    chunk.clear();
+                }
+            }
+            shared.push_batch(chunk.begin(), chunk.end());
+        }));
+    }
+    for (int c = 0; c < CONSUMERS; ++c) {
+        consumers.push_back(std::thread([&shared, &results, c]() {
+            int value;
+            Deque<int> out;
+            if (c == 0) {
+                while (shared.pop(value))
+                    results[c].push_back(value);
+            } else if (c == 1) {
+                while (shared.pop_batch(16, out) > 0) {
+                    results[c].insert(results[c].end(), out.begin(), out.end());
+                    out.clear();
+                }
+            } else {
+                while (!shared.is_closed() || !shared.empty()) {
+                    if (shared.wait_pop_for(value, std::chrono::milliseconds(1)))
+                        results[c].push_back(value);
+                }
+            }
+        }));
+    }
+    for (size_t i = 0; i < producers.size(); ++i)
+        producers[i].join();
+    shared.close();
+    for (size_t i = 0; i < consumers.size(); ++i)
+        consumers[i].join();
+    std::vector<int> all;
+    for (int c = 0; c < CONSUMERS; ++c)
+        all.insert(all.end(), results[c].begin(), results[c].end());
+    std::sort(all.begin(), all.end());
+    ASSERT_EQ(COUNT, all.size());
+    for (int i = 0; i < COUNT; ++i)
+        ASSERT_EQ(i, all[i]);
+}
+
+#ifdef DEQUE_HAS_MEMORY_RESOURCE
+TEST(TestDequeElements, test_pmr_deque) {
+    char arena[1 << 16];
+    std::pmr::monotonic_buffer_resource resource(arena, sizeof(arena), std::pmr::null_memory_resource());
+    pmr::Deque<int> arena_dq(&resource);
+    for (int i = 0; i < 1000; ++i)
+        arena_dq.push_back(i);
+    ASSERT_EQ(&resource, arena_dq.get_allocator().resource());
+    pmr::Deque<int> copy(arena_dq);
+    ASSERT_NE(&resource, copy.get_allocator().resource());
+    for (int i = 0; i < 1000; ++i)
+        ASSERT_EQ(i, copy[i]);
+}
+
+TEST(TestDequeElements, test_pmr_deque_move) {
+    std::pmr::monotonic_buffer_resource first_resource, second_resource;
+    pmr::Deque<std::pmr::string> first(&first_resource);
+    for (int i = 0; i < 100; ++i)
+        first.emplace_back(40, 'a' + i % 26);
+
+    pmr::Deque<std::pmr::string> same_resource(&first_resource);
+    same_resource = std::move(first);
+    ASSERT_TRUE(first.empty());
+    ASSERT_EQ(100u, same_resource.size());
+
+    pmr::Deque<std::pmr::string> other_resource(&second_resource);
+    other_resource = std::move(same_resource);
+    ASSERT_EQ(&second_resource, other_resource.get_allocator().resource());
+    ASSERT_EQ(100u, other_resource.size());
+    for (int i = 0; i < 100; ++i)
+        ASSERT_EQ(std::pmr::string(40, 'a' + i % 26), other_resource[i]);
+}
+#endif
+
+// Benchmarks
+
+// Same layout as int, but not trivially copyable, so Deque relocates it element by element
+struct NonTrivialInt {
+    int value;
+
+    NonTrivialInt(int value) : value(value) {}
+
+    NonTrivialInt(const NonTrivialInt& other) : value(other.value) {}
+};
+
+// Times one relocation of a full, wrapped ring of at least count elements, and nothing else
+template <class Elem>
+double measure_growth(size_t count) {
+    Deque<Elem> grown;
+    for (int i = 0; grown.size() < count || grown.size() < grown.capacity(); ++i)
+        i % 2 ? grown.push_back(Elem(i)) : grown.push_front(Elem(i));
+    std::chrono::time_point<std::chrono::system_clock> time1, time2;
+    time1 = std::chrono::system_clock::now();
+    grown.reserve(grown.capacity() * 2);
+    time2 = std::chrono::system_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(time2 - time1).count();
+}
+
+TEST(TestDequeBenchmarks, test_trivially_copyable_growth) {
+    const int SIZES[] = {1 << 18, 1 << 20, 1 << 22};
+    for (int size : SIZES) {
+        double time_memcpy = measure_growth<int>(size);
+        double time_loop = measure_growth<NonTrivialInt>(size);
+        std::cout << "Relocating " << size << " elements: memcpy " << time_memcpy << " us, element loop "
+                  << time_loop << " us\n";
+    }
+}
+
+TEST(TestDequeBenchmarks, test_indexed_read_mask_vs_modulo) {
+    const int SIZES[] = {1 << 10, 1 << 16, 1 << 22};
+    const int TOTAL_READS = 1 << 24;
+    std::chrono::time_point<std::chrono::system_clock> time1, time2;
+    for (int size : SIZES) {
+        Deque<int> read_dq;
+        for (int i = 0; i < size; ++i)
+            i % 2 ? read_dq.push_back(i) : read_dq.push_front(i);
+
+        // The same ring indexed the way Deque did before: (head + pos) % capacity
+        size_t capacity = size + 1;
+        size_t head = capacity / 2;
+        std::vector<int> ring(capacity);
+        for (int i = 0; i < size; ++i)
+            ring[(head + i) % capacity] = read_dq[i];
+
+        long long sum_mask = 0, sum_modulo = 0;
+        time1 = std::chrono::system_clock::now();
+        for (int pass = 0; pass < TOTAL_READS / size; ++pass)
+            for (int i = 0; i < size; ++i)
+                sum_mask += read_dq[i];
+        time2 = std::chrono::system_clock::now();
+        double time_mask = std::chrono::duration_cast<std::chrono::microseconds>(time2 - time1).count();
+
+        time1 = std::chrono::system_clock::now();
+        for (int pass = 0; pass < TOTAL_READS / size; ++pass)
+            for (int i = 0; i < size; ++i)
+                sum_modulo += ring[(head + i) % capacity];
+        time2 = std::chrono::system_clock::now();
+        double time_modulo = std::chrono::duration_cast<std::chrono::microseconds>(time2 - time1).count();
+
+        ASSERT_EQ(sum_modulo, sum_mask);
+        std::cout << "Indexed reads, size " << size << ": mask " << time_mask << " us, modulo "
+                  << time_modulo << " us\n";
+    }
+}
+
+TEST(TestDequeBenchmarks, test_push_pop_at_capacity_boundary) {
+    const int SIZES[] = {1 << 10, 1 << 14, 1 << 18, 1 << 22};
+    const int OPERATIONS = 1 << 20;
+    std::chrono::time_point<std::chrono::system_clock> time1, time2;
+    double time_current = 0;
+    double time_previous = 0;
+    for (size_t s = 0; s < sizeof(SIZES) / sizeof(SIZES[0]); ++s) {
+        Deque<int> boundary_dq;
+        // The ring is full: the first push grows it, and hysteresis keeps it from shrinking back
+        for (int i = 0; i < SIZES[s]; ++i)
+            boundary_dq.push_back(i);
+
+        size_t capacity = boundary_dq.capacity();
+        int resizes = 0;
+        time1 = std::chrono::system_clock::now();
+        for (int i = 0; i < OPERATIONS; ++i) {
+            boundary_dq.push_back(i);
+            resizes += boundary_dq.capacity() != capacity;
+            capacity = boundary_dq.capacity();
+            boundary_dq.pop_back();
+            resizes += boundary_dq.capacity() != capacity;
+            capacity = boundary_dq.capacity();
+        }
+        time2 = std::chrono::system_clock::now();
+        time_current = std::chrono::duration_cast<std::chrono::microseconds>(time2 - time1).count();
+        ASSERT_LE(resizes, 1);
+
+        // Pop below a quarter of the capacity the ring shrank to on the way, so the first pop shrinks it again
+        while (boundary_dq.size() > (size_t)SIZES[s] / 4 - 1)
+            boundary_dq.pop_front();
+        capacity = boundary_dq.capacity();
+        resizes = 0;
+        time1 = std::chrono::system_clock::now();
+        for (int i = 0; i < OPERATIONS; ++i) {
+            boundary_dq.pop_front();
+            resizes += boundary_dq.capacity() != capacity;
+            capacity = boundary_dq.capacity();
+            boundary_dq.push_front(i);
+            resizes += boundary_dq.capacity() != capacity;
+            capacity = boundary_dq.capacity();
+        }
+        time2 = std::chrono::system_clock::now();
+        time_current += std::chrono::duration_cast<std::chrono::microseconds>(time2 - time1).count();
+        ASSERT_LE(resizes, 1);
+
+        std::cout << "Push/pop at the boundary of " << SIZES[s] << " elements: " << time_current << " us";
+        if (s > 0)
+            std::cout << ", " << time_current / time_previous << " times the previous size";
+        std::cout << "\n";
+        time_previous = time_current;
+    }
+}
+
+template <class DequeType>
+void measure_push_latency(const char* name, int count) {
+    std::vector<long long> latencies(count);
+    DequeType latency_dq;
+    for (int i = 0; i < count; ++i) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        latency_dq.push_back(i);
+        std::chrono::steady_clock::time_point finish = std::chrono::steady_clock::now();
+        latencies[i] = std::chrono::duration_cast<std::chrono::nanoseconds>(finish - start).count();
+    }
+    std::sort(latencies.begin(), latencies.end());
+    std::cout << name << " push latency: p50 " << latencies[count / 2] << " ns, p99.9 "
+              << latencies[count - count / 1000 - 1] << " ns, max " << latencies.back() << " ns\n";
+}
+
+TEST(TestDequeBenchmarks, test_incremental_growth_latency) {
+    const int COUNT = 1 << 22;
+    measure_push_latency<Deque<int>>("Deque", COUNT);
+    measure_push_latency<IncrementalDeque<int>>("IncrementalDeque", COUNT);
+}
+
+TEST(TestDequeBenchmarks, test_fill_clear_cycle) {
+    const int BATCH = 1 << 12;
+    const int CYCLES = 1 << 10;
+    std::chrono::time_point<std::chrono::system_clock> time1, time2;
+
+    Deque<int> batch_dq;
+    time1 = std::chrono::system_clock::now();
+    for (int cycle = 0; cycle < CYCLES; ++cycle) {
+        for (int i = 0; i < BATCH; ++i)
+            batch_dq.push_back(i);
+        // What clear() used to do
+        batch_dq = Deque<int>();
+    }
+    time2 = std::chrono::system_clock::now();
+    double time_reallocating = std::chrono::duration_cast<std::chrono::microseconds>(time2 - time1).count();
+
+    time1 = std::chrono::system_clock::now();
+    batch_dq.reserve(BATCH);
+    for (int cycle = 0; cycle < CYCLES; ++cycle) {
+        for (int i = 0; i < BATCH; ++i)
+            batch_dq.push_back(i);
+        batch_dq.clear();
+    }
+    time2 = std::chrono::system_clock::now();
+    double time_keeping = std::chrono::duration_cast<std::chrono::microseconds>(time2 - time1).count();
+
+    std::cout << "Fill/clear of " << BATCH << " elements: reallocating " << time_reallocating
+              << " us, keeping capacity " << time_keeping << " us\n";
+}
+
+TEST(TestDequeBenchmarks, test_bulk_append) {
+    const int COUNT = 1 << 20;
+    std::vector<int> values(COUNT);
+    for (int i = 0; i < COUNT; ++i)
+        values[i] = i;
+    std::chrono::time_point<std::chrono::system_clock> time1, time2;
+
+    time1 = std::chrono::system_clock::now();
+    {
+        Deque<int> loaded;
+        for (int i = 0; i < COUNT; ++i)
+            loaded.push_back(values[i]);
+    }
+    time2 = std::chrono::system_clock::now();
+    double time_push = std::chrono::duration_cast<std::chrono::microseconds>(time2 - time1).count();
+
+    time1 = std::chrono::system_clock::now();
+    {
+        Deque<int> loaded;
+        loaded.append(values.begin(), values.end());
+    }
+    time2 = std::chrono::system_clock::now();
+    double time_append = std::chrono::duration_cast<std::chrono::microseconds>(time2 - time1).count();
+
+    time1 = std::chrono::system_clock::now();
+    {
+        Deque<int> loaded;
+        loaded.append(values.data(), values.data() + COUNT);
+    }
+    time2 = std::chrono::system_clock::now();
+    double time_memcpy = std::chrono::duration_cast<std::chrono::microseconds>(time2 - time1).count();
+
+    std::cout << "Loading " << COUNT << " elements: push_back " << time_push << " us, append from vector iterators "
+              << time_append << " us, append from pointers " << time_memcpy << " us\n";
+}
+
+TEST(TestDequeBenchmarks, test_bulk_pop) {
+    const int COUNT = 1 << 22;
+    const int BATCH = 1 << 12;
+    std::vector<int> batch(BATCH);
+    std::chrono::time_point<std::chrono::system_clock> time1, time2;
+    long long sum_single = 0, sum_bulk = 0;
+
+    Deque<int> consumed;
+    for (int i = 0; i < COUNT; ++i)
+        consumed.push_back(i);
+    time1 = std::chrono::system_clock::now();
+    while (!consumed.empty()) {
+        for (int i = 0; i < BATCH && !consumed.empty(); ++i) {
+            batch[i] = consumed.front();
+            consumed.pop_front();
+        }
+        sum_single += batch[0];
+    }
+    time2 = std::chrono::system_clock::now();
+    double time_single = std::chrono::duration_cast<std::chrono::microseconds>(time2 - time1).count();
+
+    for (int i = 0; i < COUNT; ++i)
+        consumed.push_back(i);
+    time1 = std::chrono::system_clock::now();
+    while (!consumed.empty()) {
+        consumed.pop_front_n(BATCH, batch.data());
+        sum_bulk += batch[0];
+    }
+    time2 = std::chrono::system_clock::now();
+    double time_bulk = std::chrono::duration_cast<std::chrono::microseconds>(time2 - time1).count();
+
+    ASSERT_EQ(sum_single, sum_bulk);
+    std::cout << "Consuming " << COUNT << " elements in batches of " << BATCH << ": front/pop_front "
+              << time_single << " us, pop_front_n " << time_bulk << " us\n";
+}
+
+TEST(TestDequeBenchmarks, test_segmented_algorithms) {
+    const int COUNT = 1 << 20;
+    const int REPEAT = 10;
+    Deque<int> ring_dq;
+    std::deque<int> std_dq;
+    std::vector<int> vector(COUNT);
+    // Start in the middle of the buffer, so that the elements wrap around
+    for (int i = 0; i < COUNT / 2; ++i)
+        ring_dq.push_back(i);
+    for (int i = 0; i < COUNT / 2; ++i)
+        ring_dq.pop_front();
+    for (int i = 0; i < COUNT; ++i) {
+        ring_dq.push_back(i);
+        std_dq.push_back(i);
+        vector[i] = i;
+    }
+    const Deque<int>& const_dq = ring_dq;
+    std::vector<int> out(COUNT);
+    std::chrono::time_point<std::chrono::system_clock> time1, time2;
+    long long check_iterators = 0, check_segmented = 0, check_std_deque = 0, check_vector = 0;
+
+    time1 = std::chrono::system_clock::now();
+    for (int r = 0; r < REPEAT; ++r) {
+        std::copy(const_dq.begin(), const_dq.end(), out.begin());
+        check_iterators += std::accumulate(const_dq.begin(), const_dq.end(), 0LL);
+        check_iterators += std::find(const_dq.begin(), const_dq.end(), COUNT - 1) - const_dq.begin();
+    }
+    time2 = std::chrono::system_clock::now();
+    double time_iterators = std::chrono::duration_cast<std::chrono::microseconds>(time2 - time1).count();
+
+    time1 = std::chrono::system_clock::now();
+    for (int r = 0; r < REPEAT; ++r) {
+        segmented::copy(const_dq.begin(), const_dq.end(), out.begin());
+        check_segmented += segmented::accumulate(const_dq.begin(), const_dq.end(), 0LL);
+        check_segmented += segmented::find(const_dq.begin(), const_dq.end(), COUNT - 1) - const_dq.begin();
+    }
+    time2 = std::chrono::system_clock::now();
+    double time_segmented = std::chrono::duration_cast<std::chrono::microseconds>(time2 - time1).count();
+
+    time1 = std::chrono::system_clock::now();
+    for (int r = 0; r < REPEAT; ++r) {
+        std::copy(std_dq.begin(), std_dq.end(), out.begin());
+        check_std_deque += std::accumulate(std_dq.begin(), std_dq.end(), 0LL);
+        check_std_deque += std::find(std_dq.begin(), std_dq.end(), COUNT - 1) - std_dq.begin();
+    }
+    time2 = std::chrono::system_clock::now();
+    double time_std_deque = std::chrono::duration_cast<std::chrono::microseconds>(time2 - time1).count();
+
+    time1 = std::chrono::system_clock::now();
+    for (int r = 0; r < REPEAT; ++r) {
+        std::copy(vector.begin(), vector.end(), out.begin());
+        check_vector += std::accumulate(vector.begin(), vector.end(), 0LL);
+        check_vector += std::find(vector.begin(), vector.end(), COUNT - 1) - vector.begin();
+    }
+    time2 = std::chrono::system_clock::now();
+    double time_vector = std::chrono::duration_cast<std::chrono::microseconds>(time2 - time1).count();
+
+    ASSERT_EQ(check_vector, check_iterators);
+    ASSERT_EQ(check_vector, check_segmented);
+    ASSERT_EQ(check_vector, check_std_deque);
+    std::cout << "copy + accumulate + find over " << COUNT << " elements, " << REPEAT << " times: Deque iterators "
+              << time_iterators << " us, segmented " << time_segmented << " us, std::deque " << time_std_deque
+              << " us, std::vector " << time_vector << " us\n";
+}
+
+TEST(TestDequeBenchmarks, test_small_deque_allocations) {
+    const int COUNT = 1 << 18;
+    const int ELEMENTS = 6;
+    std::chrono::time_point<std::chrono::system_clock> time1, time2;
+    long long sum_heap = 0, sum_inline = 0;
+
+    time1 = std::chrono::system_clock::now();
+    for (int i = 0; i < COUNT; ++i) {
+        Deque<int> queue;
+        for (int j = 0; j < ELEMENTS; ++j)
+            queue.push_back(i + j);
+        sum_heap += queue.front() + queue.back();
+    }
+    time2 = std::chrono::system_clock::now();
+    double time_heap = std::chrono::duration_cast<std::chrono::microseconds>(time2 - time1).count();
+
+    time1 = std::chrono::system_clock::now();
+    for (int i = 0; i < COUNT; ++i) {
+        SmallDeque<int, 8> queue;
+        for (int j = 0; j < ELEMENTS; ++j)
+            queue.push_back(i + j);
+        sum_inline += queue.front() + queue.back();
+    }
+    time2 = std::chrono::system_clock::now();
+    double time_inline = std::chrono::duration_cast<std::chrono::microseconds>(time2 - time1).count();
+
+    ASSERT_EQ(sum_heap, sum_inline);
+    std::cout << COUNT << " short-lived queues of " << ELEMENTS << " elements: Deque " << time_heap
+              << " us, SmallDeque<int, 8> " << time_inline << " us\n";
+}
+
+TEST(TestDequeBenchmarks, test_bounded_last_samples) {
+    const int COUNT = 1 << 22;
+    const size_t WINDOW = 1024;
+    std::chrono::time_point<std::chrono::system_clock> time1, time2;
+
+    Deque<int> window_dq;
+    time1 = std::chrono::system_clock::now();
+    for (int i = 0; i < COUNT; ++i) {
+        if (window_dq.size() == WINDOW)
+            window_dq.pop_front();
+        window_dq.push_back(i);
+    }
+    time2 = std::chrono::system_clock::now();
+    double time_deque = std::chrono::duration_cast<std::chrono::microseconds>(time2 - time1).count();
+
+    BoundedDeque<int> bounded_dq(WINDOW);
+    time1 = std::chrono::system_clock::now();
+    for (int i = 0; i < COUNT; ++i)
+        bounded_dq.push_back(i);
+    time2 = std::chrono::system_clock::now();
+    double time_bounded = std::chrono::duration_cast<std::chrono::microseconds>(time2 - time1).count();
+
+    ASSERT_TRUE(std::equal(window_dq.begin(), window_dq.end(), bounded_dq.begin()));
+    std::cout << "Keeping the last " << WINDOW << " of " << COUNT << " samples: Deque pop_front/push_back "
+              << time_deque << " us, BoundedDeque push_back " << time_bounded << " us\n";
+}
+
+template <size_t Bytes>
+struct Payload {
+    char bytes[Bytes];
+
+    Payload(int value) {
+        std::memset(bytes, value, Bytes);
+    }
+};
+
+template <class DequeType>
+double measure_queue_pass(int count) {
+    std::chrono::time_point<std::chrono::system_clock> time1, time2;
+    time1 = std::chrono::system_clock::now();
+    {
+        DequeType queue;
+        for (int i = 0; i < count; ++i)
+            queue.emplace_back(i);
+        for (int i = 0; i < count; ++i) {
+            queue.pop_front();
+            queue.emplace_back(i);
+        }
+        while (!queue.empty())
+            queue.pop_front();
+    }
+    time2 = std::chrono::system_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(time2 - time1).count();
+}
+
+template <size_t Bytes>
+void print_segmented_crossover() {
+    const int COUNTS[] = {1 << 6, 1 << 10, 1 << 14, 1 << 17};
+    for (int count : COUNTS) {
+        int repeat = (1 << 17) / count;
+        double time_ring = 0, time_blocks = 0;
+        for (int r = 0; r < repeat; ++r) {
+            time_ring += measure_queue_pass<Deque<Payload<Bytes>>>(count);
+            time_blocks += measure_queue_pass<SegmentedDeque<Payload<Bytes>>>(count);
+        }
+        std::cout << Bytes << "-byte elements, queue of " << count << " x " << repeat << ": Deque " << time_ring
+                  << " us, SegmentedDeque " << time_blocks << " us\n";
+    }
+}
+
+TEST(TestDequeBenchmarks, test_segmented_crossover) {
+    print_segmented_crossover<8>();
+    print_segmented_crossover<64>();
+    print_segmented_crossover<512>();
+}
+
+// Deque behind a mutex, the baseline for the concurrent deques
+template <class T>
+class LockedDeque {
+
+private:
+
+    std::mutex _mutex;
+    Deque<T> _dq;
+
+public:
+
+    bool try_push(const T& elem) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _dq.push_back(elem);
+        return true;
+    }
+
+    bool try_pop(T& out) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_dq.empty())
+            return false;
+        out = _dq.front();
+        _dq.pop_front();
+        return true;
+    }
+};
+
+// Best effort: the threads stay on their CPUs, or share one if there are not enough.
+// Only spawned threads are pinned, so the test runner's own thread keeps its affinity.
+void pin_to_cpu(std::thread& thread, unsigned cpu) {
+#if defined(__linux__)
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu % std::max(1u, std::thread::hardware_concurrency()), &cpus);
+    pthread_setaffinity_np(thread.native_handle(), sizeof(cpus), &cpus);
+#endif
+}
+
+template <class Queue>
+double measure_handoff(Queue& queue, int count, int batch) {
+    std::chrono::time_point<std::chrono::system_clock> time1, time2;
+    long long sum = 0;
+    time1 = std::chrono::system_clock::now();
+    std::thread consumer([&queue, &sum, count]() {
+        int value;
+        for (int received = 0; received < count;) {
+            if (queue.try_pop(value)) {
+                sum += value;
+                ++received;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+    pin_to_cpu(consumer, 1);
+    std::thread producer([&queue, count, batch]() {
+        std::vector<int> values(batch);
+        for (int i = 0; i < count; i += batch) {
+            for (int j = 0; j < batch; ++j)
+                values[j] = i + j;
+            for (int j = 0; j < batch; ++j) {
+                while (!queue.try_push(values[j]))
+                    std::this_thread::yield();
+            }
+        }
+    });
+    pin_to_cpu(producer, 0);
+    producer.join();
+    consumer.join();
+    time2 = std::chrono::system_clock::now();
+    EXPECT_EQ((long long)count * (count - 1) / 2, sum);
+    return std::chrono::duration_cast<std::chrono::microseconds>(time2 - time1).count();
+}
+
+double measure_spsc_batched_handoff(int count, int batch) {
+    SpscDeque<int> queue(1024);
+    std::chrono::time_point<std::chrono::system_clock> time1, time2;
+    long long sum = 0;
+    time1 = std::chrono::system_clock::now();
+    std::thread consumer([&queue, &sum, count, batch]() {
+        std::vector<int> values(batch);
+        for (int received = 0; received < count;) {
+            size_t popped = queue.try_pop_n(values.begin(), batch);
+            if (popped == 0)
+                std::this_thread::yield();
+            for (size_t j = 0; j < popped; ++j)
+                sum += values[j];
+            received += popped;
+        }
+    });
+    pin_to_cpu(consumer, 1);
+    std::thread producer([&queue, count, batch]() {
+        std::vector<int> values(batch);
+        for (int i = 0; i < count; i += batch) {
+            for (int j = 0; j < batch; ++j)
+                values[j] = i + j;
+            for (int pushed = 0; pushed < batch;) {
+                pushed += queue.try_push_n(values.begin() + pushed, batch - pushed);
+                if (pushed < batch)
+                    std::this_thread::yield();
+            }
+        }
+    });
+    pin_to_cpu(producer, 0);
+    producer.join();
+    consumer.join();
+    time2 = std::chrono::system_clock::now();
+    EXPECT_EQ((long long)count * (count - 1) / 2, sum);
+    return std::chrono::duration_cast<std::chrono::microseconds>(time2 - time1).count();
+}
+
+// Average time for a message to go to the other thread and back
+template <class Queue>
+double measure_round_trip(int rounds) {
+    Queue there, back;
+    std::thread echo([&there, &back, rounds]() {
+        int value;
+        for (int i = 0; i < rounds; ++i) {
+            while (!there.try_pop(value))
+                std::this_thread::yield();
+            back.try_push(value);
+        }
+    });
+    pin_to_cpu(echo, 1);
+    double elapsed = 0;
+    std::thread sender([&there, &back, &elapsed, rounds]() {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        int value;
+        for (int i = 0; i < rounds; ++i) {
+            there.try_push(i);
+            while (!back.try_pop(value))
+                std::this_thread::yield();
+        }
+        std::chrono::steady_clock::time_point finish = std::chrono::steady_clock::now();
+        elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(finish - start).count();
+    });
+    pin_to_cpu(sender, 0);
+    sender.join();
+    echo.join();
+    return elapsed / rounds;
+}
+
+struct SpscIntDeque : SpscDeque<int> {
+    SpscIntDeque() : SpscDeque<int>(1024) {}
+};
+
+TEST(TestDequeBenchmarks, test_spsc_handoff) {
+    const int COUNT = 1 << 20;
+    const int BATCH = 64;
+    const int ROUNDS = 1 << 12;
+    LockedDeque<int> locked;
+    SpscDeque<int> spsc(1024);
+    double time_locked = measure_handoff(locked, COUNT, BATCH);
+    double time_spsc = measure_handoff(spsc, COUNT, BATCH);
+    double time_batched = measure_spsc_batched_handoff(COUNT, BATCH);
+    std::cout << "Passing " << COUNT << " elements between two threads: Deque with mutex " << time_locked
+              << " us, SpscDeque " << time_spsc << " us, SpscDeque in batches of " << BATCH << " "
+              << time_batched << " us\n";
+    std::cout << "Round trip: Deque with mutex " << measure_round_trip<LockedDeque<int>>(ROUNDS)
+              << " ns, SpscDeque " << measure_round_trip<SpscIntDeque>(ROUNDS) << " ns\n";
+}
+
+// Producers push and consumers pop count elements in total; a single thread alternates both
+template <class Queue>
+double measure_mpmc_scaling(Queue& queue, int threads, int count) {
+    std::chrono::time_point<std::chrono::system_clock> time1, time2;
+    std::atomic<long long> sum(0);
+    time1 = std::chrono::system_clock::now();
+    if (threads == 1) {
+        int value = 0;
+        long long local_sum = 0;
+        for (int i = 0; i < count; ++i) {
+            queue.try_push(i);
+            // A failed pop leaves the checksum short
+            if (queue.try_pop(value))
+                local_sum += value;
+        }
+        sum += local_sum;
+    } else {
+        int producers = threads / 2;
+        int consumers = threads - producers;
+        std::atomic<int> consumed(0);
+        std::vector<std::thread> workers;
+        for (int p = 0; p < producers; ++p) {
+            workers.push_back(std::thread([&queue, p, producers, count]() {
+                for (int i = p; i < count; i += producers) {
+                    while (!queue.try_push(i))
+                        std::this_thread::yield();
+                }
+            }));
+        }
+        for (int c = 0; c < consumers; ++c) {
+            workers.push_back(std::thread([&queue, &sum, &consumed, count]() {
+                int value = 0;
+                long long local_sum = 0;
+                while (consumed.load(std::memory_order_relaxed) < count) {
+                    if (queue.try_pop(value)) {
+                        local_sum += value;
+                        consumed.fetch_add(1, std::memory_order_relaxed);
+                    } else {
+                        std::this_thread::yield();
+                    }
+                }
+                sum += local_sum;
+            }));
+        }
+        for (size_t i = 0; i < workers.size(); ++i)
+            pin_to_cpu(workers[i], i);
+        for (size_t i = 0; i < workers.size(); ++i)
+            workers[i].join();
+    }
+    time2 = std::chrono::system_clock::now();
+    EXPECT_EQ((long long)count * (count - 1) / 2, sum.load());
+    return std::chrono::duration_cast<std::chrono::microseconds>(time2 - time1).count();
+}
+
+TEST(TestDequeBenchmarks, test_mpmc_scaling) {
+    const int COUNT = 1 << 18;
+    for (int threads = 1; threads <= 64; threads *= 2) {
+        LockedDeque<int> locked;
+        MpmcDeque<int> mpmc(1024);
+        double time_locked = measure_mpmc_scaling(locked, threads, COUNT);
+        double time_mpmc = measure_mpmc_scaling(mpmc, threads, COUNT);
+        std::cout << threads << " threads passing " << COUNT << " elements: Deque with mutex " << time_locked
+                  << " us, MpmcDeque " << time_mpmc << " us\n";
+    }
+}
+
+// Runs f in pool count times and returns the mean time in microseconds
+template <class F>
+double measure_fork_join(ForkJoinPool& pool, int count, F f) {
+    std::chrono::time_point<std::chrono::system_clock> time1, time2;
+    time1 = std::chrono::system_clock::now();
+    for (int i = 0; i < count; ++i)
+        pool.run(f);
+    time2 = std::chrono::system_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(time2 - time1).count() / (double)count;
+}
+
+TEST(TestDequeBenchmarks, test_work_stealing_fork_join) {
+    const int ROUNDS = 5;
+    const int FIB_N = 24;
+    const int FIB_CUTOFF = 8;
+    const int SORT_SIZE = 1 << 18;
+    size_t threads = std::max(2u, std::thread::hardware_concurrency());
+    ForkJoinPool stealing(threads, FORK_JOIN_WORK_STEALING);
+    ForkJoinPool global(threads, FORK_JOIN_GLOBAL_QUEUE);
+
+    long long fib = 0;
+    double fib_stealing = measure_fork_join(stealing, ROUNDS, [&stealing, &fib]() {
+        fib = parallel_fib(stealing, FIB_N, FIB_CUTOFF);
+    });
+    ASSERT_EQ(serial_fib(FIB_N), fib);
+    double fib_global = measure_fork_join(global, ROUNDS, [&global, &fib]() {
+        fib = parallel_fib(global, FIB_N, FIB_CUTOFF);
+    });
+    ASSERT_EQ(serial_fib(FIB_N), fib);
+    std::cout << "fib(" << FIB_N << ") on " << threads << " threads: work stealing " << fib_stealing
+              << " us, global queue with mutex " << fib_global << " us\n";
+
+    std::vector<int> values(SORT_SIZE);
+    for (int i = 0; i < SORT_SIZE; ++i)
+        values[i] = rand();
+    Deque<int> dq;
+    double sort_stealing = measure_fork_join(stealing, ROUNDS, [&stealing, &dq, &values]() {
+        dq.assign(values.begin(), values.end());
+        parallel_quicksort(stealing, dq.begin(), dq.end(), 256);
+    });
+    ASSERT_TRUE(std::is_sorted(dq.begin(), dq.end()));
+    double sort_global = measure_fork_join(global, ROUNDS, [&global, &dq, &values]() {
+        dq.assign(values.begin(), values.end());
+        parallel_quicksort(global, dq.begin(), dq.end(), 256);
+    });
+    ASSERT_TRUE(std::is_sorted(dq.begin(), dq.end()));
+    std::cout << "Quicksort of " << SORT_SIZE << " ints in a Deque on " << threads << " threads: work stealing "
+              << sort_stealing << " us, global queue with mutex " << sort_global << " us\n";
+}
+
+// Locks once per element and wakes one waiter per push
+template <class T>
+class HandRolledBlockingDeque {
+
+private:
+
+    std::mutex _mutex;
+    std::condition_variable _not_empty;
+    Deque<T> _dq;
+    bool _closed = false;
+
+public:
+
+    void push(const T& elem) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _dq.push_back(elem);
+        }
+        _not_empty.notify_one();
+    }
+
+    bool pop(T& out) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _not_empty.wait(lock, [this]() { return _closed || !_dq.empty(); });
+        if (_dq.empty())
+            return false;
+        out = _dq.front();
+        _dq.pop_front();
+        return true;
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _closed = true;
+        }
+        _not_empty.notify_all();
+    }
+};
+
+// Producers push count elements in total in batches, consumers pop until the deque is closed
+template <class Produce, class Consume>
+double measure_blocking_pass(int producers, int consumers, int count, Produce produce, Consume consume,
+                             std::function<void()> close) {
+    std::chrono::time_point<std::chrono::system_clock> time1, time2;
+    std::atomic<long long> sum(0);
+    time1 = std::chrono::system_clock::now();
+    std::vector<std::thread> producing;
+    std::vector<std::thread> consuming;
+    for (int p = 0; p < producers; ++p)
+        producing.push_back(std::thread([&produce, p, producers, count]() { produce(p, producers, count); }));
+    for (int c = 0; c < consumers; ++c)
+        consuming.push_back(std::thread([&consume, &sum]() { sum += consume(); }));
+    for (size_t i = 0; i < producing.size(); ++i)
+        producing[i].join();
+    close();
+    for (size_t i = 0; i < consuming.size(); ++i)
+        consuming[i].join();
+    time2 = std::chrono::system_clock::now();
+    EXPECT_EQ((long long)count * (count - 1) / 2, sum.load());
+    return std::chrono::duration_cast<std::chrono::microseconds>(time2 - time1).count();
+}
+
+TEST(TestDequeBenchmarks, test_concurrent_deque_batches) {
+    const int COUNT = 1 << 18;
+    const int BATCH = 64;
+    for (int threads = 1; threads <= 4; threads *= 2) {
+        HandRolledBlockingDeque<int> hand_rolled;
+        double time_hand_rolled = measure_blocking_pass(threads, threads, COUNT,
+            [&hand_rolled](int p, int producers, int count) {
+                for (int i = p; i < count; i += producers)
+                    hand_rolled.push(i);
+            },
+            [&hand_rolled]() {
+                long long sum = 0;
+                int value;
+                while (hand_rolled.pop(value))
+                    sum += value;
+                return sum;
+            },
+            [&hand_rolled]() { hand_rolled.close(); });
+
+        ConcurrentDeque<int> batched(4096);
+        double time_batched = measure_blocking_pass(threads, threads, COUNT,
+            [&batched, BATCH](int p, int producers, int count) {
+                std::vector<int> chunk;
+                for (int i = p; i < count; i += producers) {
+                    chunk.push_back(i);
+                    if (chunk.size() == BATCH) {
+                        batched.push_batch(chunk.begin(), chunk.end());
+                        chunk.clear();
+                    }
+                }
+                batched.push_batch(chunk.begin(), chunk.end());
+            },
+            [&batched]() {
+                long long sum = 0;
+                Deque<int> out;
+                while (batched.pop_batch(BATCH, out) > 0) {
+                    for (size_t i = 0; i < out.size(); ++i)
+                        sum += out[i];
+                    out.clear();
+                }
+                return sum;
+            },
+            [&batched]() { batched.close(); });
+        std::cout << threads << " producers and " << threads << " consumers passing " << COUNT
+                  << " elements: hand-rolled blocking Deque " << time_hand_rolled << " us, ConcurrentDeque in batches of "
+                  << BATCH << " " << time_batched << " us\n";
+    }
+}
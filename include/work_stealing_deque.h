@@ -0,0 +1,163 @@
+//
+// Created by anton on 17.10.26.
+//
+
+#ifndef DEQUE_WORK_STEALING_DEQUE_H
+#define DEQUE_WORK_STEALING_DEQUE_H
+
+#include <stdexcept>
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+#include "deque_policy.h"
+
+// Lock-free work-stealing deque (Chase-Lev, with the C11 memory orderings of Le et al., 2013).
+//
+// One owner thread pushes and pops at the back, any number of thief threads steal from the front.
+// The ring is a power-of-two array that the owner doubles when it is full; thieves may still be
+// reading the old array, so replaced arrays are kept until the deque is destroyed.
+//
+// A push publishes the element with a release store of _bottom. A pop writes _bottom and a steal reads
+// _top before a sequentially consistent fence, so the two cannot both miss each other's index when they
+// race for the last element; on x86 only that fence and the compare-and-swap cost anything, on ARM
+// the acquire and release accesses are plain ldar/stlr.
+//
+// Thieves read an element before they know whether their steal succeeds, so elements are stored
+// in atomics and T must be trivially copyable; pointers to tasks are the usual choice.
+template <class T>
+class WorkStealingDeque {
+
+private:
+
+    static_assert(std::is_trivially_copyable<T>::value, "WorkStealingDeque: T must be trivially copyable");
+
+    struct Array {
+        size_t capacity;
+        std::atomic<T>* items;
+
+        explicit Array(size_t capacity) : capacity(capacity), items(new std::atomic<T>[capacity]) {}
+
+        ~Array() {
+            delete[] items;
+        }
+
+        T get(std::ptrdiff_t pos) const {
+            return items[pos & (capacity - 1)].load(std::memory_order_relaxed);
+        }
+
+        void put(std::ptrdiff_t pos, T elem) {
+            items[pos & (capacity - 1)].store(elem, std::memory_order_relaxed);
+        }
+    };
+
+    // Written by thieves and by the owner taking the last element
+    alignas(DEQUE_CACHE_LINE_SIZE) std::atomic<std::ptrdiff_t> _top;
+
+    // Written only by the owner
+    alignas(DEQUE_CACHE_LINE_SIZE) std::atomic<std::ptrdiff_t> _bottom;
+    std::atomic<Array*> _array;
+    std::vector<Array*> _retired;
+
+    inline Array* grow(Array* array, std::ptrdiff_t bottom, std::ptrdiff_t top) {
+        Array* grown = new Array(array->capacity * 2);
+        for (std::ptrdiff_t pos = top; pos < bottom; ++pos)
+            grown->put(pos, array->get(pos));
+        _retired.push_back(array);
+        _array.store(grown, std::memory_order_release);
+        return grown;
+    }
+
+public:
+
+    // Constructors & destructors
+
+    // The capacity is rounded up to a power of two
+    explicit WorkStealingDeque(size_t capacity = 64) : _top(0), _bottom(0) {
+        if (capacity == 0)
+            throw std::invalid_argument("WorkStealingDeque::capacity must be positive");
+        size_t rounded = 1;
+        while (rounded < capacity)
+            rounded <<= 1;
+        _array.store(new Array(rounded), std::memory_order_relaxed);
+    }
+
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+
+    WorkStealingDeque& operator =(const WorkStealingDeque&) = delete;
+
+    // No thread may use the deque any more
+    ~WorkStealingDeque() {
+        delete _array.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < _retired.size(); ++i)
+            delete _retired[i];
+    }
+
+    // Capacity
+
+    // May be outdated by the time it returns
+    size_t size_approx() const {
+        std::ptrdiff_t bottom = _bottom.load(std::memory_order_relaxed);
+        std::ptrdiff_t top = _top.load(std::memory_order_relaxed);
+        return bottom > top ? static_cast<size_t>(bottom - top) : 0;
+    }
+
+    // Owner
+
+    void push_back(T elem) {
+        std::ptrdiff_t bottom = _bottom.load(std::memory_order_relaxed);
+        std::ptrdiff_t top = _top.load(std::memory_order_acquire);
+        Array* array = _array.load(std::memory_order_relaxed);
+        if (bottom - top > static_cast<std::ptrdiff_t>(array->capacity) - 1)
+            array = grow(array, bottom, top);
+        array->put(bottom, elem);
+        // Publishes the element: a thief that reads the new _bottom with acquire also sees it.
+        // The paper uses a release fence and a relaxed store instead, which ThreadSanitizer cannot check.
+        _bottom.store(bottom + 1, std::memory_order_release);
+    }
+
+    // Takes the most recently pushed element. Only the last element can be contended,
+    // which is settled by the same compare-and-swap on _top that thieves use.
+    bool try_pop_back(T& out) {
+        std::ptrdiff_t bottom = _bottom.load(std::memory_order_relaxed) - 1;
+        Array* array = _array.load(std::memory_order_relaxed);
+        _bottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::ptrdiff_t top = _top.load(std::memory_order_relaxed);
+
+        if (top > bottom) {
+            _bottom.store(bottom + 1, std::memory_order_relaxed);
+            return false;
+        }
+        T elem = array->get(bottom);
+        if (top < bottom) {
+            out = elem;
+            return true;
+        }
+        bool won = _top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        _bottom.store(bottom + 1, std::memory_order_relaxed);
+        if (won)
+            out = elem;
+        return won;
+    }
+
+    // Thieves
+
+    // Takes the oldest element. Fails if the deque is empty or another thread took the element first.
+    bool try_steal_front(T& out) {
+        std::ptrdiff_t top = _top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::ptrdiff_t bottom = _bottom.load(std::memory_order_acquire);
+        if (top >= bottom)
+            return false;
+        Array* array = _array.load(std::memory_order_acquire);
+        T elem = array->get(top);
+        if (!_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return false;
+        out = elem;
+        return true;
+    }
+};
+
+#endif //DEQUE_WORK_STEALING_DEQUE_H